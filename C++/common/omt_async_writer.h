@@ -0,0 +1,509 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_async_writer.h writes a file sequentially in large aligned chunks without the caller
+	waiting on the disk, for recording many streams at once.
+
+	write() copies into the current chunk, a 4 KB aligned buffer of chunkBytes (4 MB by default).
+	A full chunk is handed to the background and the next free one is used; the caller only waits
+	when every chunk is still being written, which is counted as a stall. By default a writer
+	thread issues the writes with pwrite. Built with OMT_ASYNC_WRITER_IO_URING defined (and linked
+	with -luring) they are queued on an io_uring instead and no thread is started.
+
+	With direct set the file is opened with O_DIRECT (F_NOCACHE on macOS) so recordings do not
+	push everything else out of the page cache. Chunks are then always written whole; close()
+	truncates the file to the bytes actually written.  */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef OMT_ASYNC_WRITER_IO_URING
+#include <liburing.h>
+#endif
+
+struct OMTAsyncWriterOptions
+{
+    size_t chunkBytes = 4 << 20;    // Rounded up to a multiple of kBlock
+    int chunks = 4;                 // Chunks in memory, so chunks - 1 can be in flight while one fills
+    bool direct = false;            // Bypass the page cache
+};
+
+struct OMTAsyncWriterStats
+{
+    uint64_t bytesWritten;          // Reached the file
+    uint64_t chunksWritten;
+    uint64_t stalls;                // Writes that had to wait for a free chunk
+    uint64_t stallMicroseconds;
+    int inFlight;                   // Chunks queued or being written
+};
+
+class OMTAsyncWriter
+{
+public:
+    static const size_t kBlock = 4096;
+
+    explicit OMTAsyncWriter(const OMTAsyncWriterOptions& options = OMTAsyncWriterOptions())
+        : options_(options), fd_(-1), current_(-1), fill_(0), position_(0), filePosition_(0), failed_(false),
+          stopping_(false), bytesWritten_(0), chunksWritten_(0), stalls_(0), stallMicroseconds_(0), inFlight_(0)
+    {
+        options_.chunkBytes = (options_.chunkBytes + kBlock - 1) / kBlock * kBlock;
+        if (options_.chunkBytes == 0)
+        {
+            options_.chunkBytes = kBlock;
+        }
+        if (options_.chunks < 2)
+        {
+            options_.chunks = 2;
+        }
+    }
+
+    ~OMTAsyncWriter() { close(); }
+
+    bool open(const char* path, std::string& error)
+    {
+        close();
+        int flags = O_RDWR | O_CREAT | O_TRUNC;     // writeAt reads back the blocks it patches
+#ifdef O_DIRECT
+        if (options_.direct)
+        {
+            flags |= O_DIRECT;
+        }
+#endif
+        fd_ = ::open(path, flags, 0644);
+        if (fd_ < 0)
+        {
+            error = std::string("cannot create ") + path + ": " + strerror(errno);
+            return false;
+        }
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+        if (options_.direct)
+        {
+            fcntl(fd_, F_NOCACHE, 1);
+        }
+#endif
+        for (int i = 0; i < options_.chunks; i++)
+        {
+            void* buffer = NULL;
+            if (posix_memalign(&buffer, kBlock, options_.chunkBytes) != 0)
+            {
+                error = "out of memory for write buffers";
+                close();
+                return false;
+            }
+            Chunk chunk = { (uint8_t*)buffer, 0, 0 };
+            chunks_.push_back(chunk);
+            free_.push_back(i);
+        }
+#ifdef OMT_ASYNC_WRITER_IO_URING
+        if (io_uring_queue_init((unsigned)options_.chunks, &ring_, 0) != 0)
+        {
+            error = "io_uring_queue_init failed";
+            close();
+            return false;
+        }
+#else
+        stopping_ = false;
+        thread_ = std::thread(&OMTAsyncWriter::writerLoop, this);
+#endif
+        current_ = -1;
+        fill_ = 0;
+        position_ = 0;
+        filePosition_ = 0;
+        failed_ = false;
+        return true;
+    }
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    // Appends length bytes. Returns false once any write to the file has failed.
+    bool write(const void* data, size_t length)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        while (length > 0)
+        {
+            if (failed_ || !takeChunk())
+            {
+                return false;
+            }
+            size_t n = options_.chunkBytes - fill_;
+            if (n > length)
+            {
+                n = length;
+            }
+            if (bytes)
+            {
+                memcpy(chunks_[current_].data + fill_, bytes, n);
+                bytes += n;
+            }
+            else
+            {
+                memset(chunks_[current_].data + fill_, 0, n);
+            }
+            fill_ += n;
+            position_ += n;
+            length -= n;
+            if (fill_ == options_.chunkBytes)
+            {
+                submit();
+            }
+        }
+        return !failed_;
+    }
+
+    // Appends zeros up to the next multiple of alignment
+    bool pad(size_t alignment)
+    {
+        size_t extra = (size_t)((alignment - position_ % alignment) % alignment);
+        return extra == 0 || write(NULL, extra);
+    }
+
+    // True if length bytes can be written now without waiting for the disk
+    bool writable(size_t length)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t room = (current_ >= 0 ? options_.chunkBytes - fill_ : 0) + free_.size() * options_.chunkBytes;
+        return room >= length;
+    }
+
+    // Bytes written so far, which is where the next write lands
+    uint64_t position() const { return position_; }
+
+    // Writes everything buffered, then replaces bytes earlier in the file, e.g. a header whose
+    // contents are only known at the end. Synchronous.
+    bool writeAt(uint64_t offset, const void* data, size_t length)
+    {
+        if (!flush() || offset + length > filePosition_)
+        {
+            return false;
+        }
+        // Read, modify and write whole blocks so this also works with O_DIRECT
+        uint64_t start = offset / kBlock * kBlock;
+        size_t span = (size_t)((offset + length + kBlock - 1) / kBlock * kBlock - start);
+        void* buffer = NULL;
+        if (posix_memalign(&buffer, kBlock, span) != 0)
+        {
+            return false;
+        }
+        memset(buffer, 0, span);
+        bool ok = pread(fd_, buffer, span, (off_t)start) >= (ssize_t)(offset + length - start);
+        if (ok)
+        {
+            memcpy((uint8_t*)buffer + (offset - start), data, length);
+            ok = pwriteAll((const uint8_t*)buffer, span, start);
+        }
+        ::free(buffer);
+        return ok;
+    }
+
+    // Writes the partly filled chunk and waits for every chunk to reach the file. With direct
+    // the last block is written whole; the file is truncated to position() in close().
+    bool flush()
+    {
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        if (current_ >= 0 && fill_ > 0)
+        {
+            submit();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (inFlight_ > 0)
+        {
+            waitForChunk(lock);
+        }
+        return !failed_;
+    }
+
+    bool close()
+    {
+        if (fd_ < 0)
+        {
+            return true;
+        }
+        bool ok = flush();
+#ifdef OMT_ASYNC_WRITER_IO_URING
+        io_uring_queue_exit(&ring_);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        queued_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+#endif
+        ok = ftruncate(fd_, (off_t)position_) == 0 && ok;
+        ok = ::close(fd_) == 0 && ok;
+        fd_ = -1;
+        for (size_t i = 0; i < chunks_.size(); i++)
+        {
+            ::free(chunks_[i].data);
+        }
+        chunks_.clear();
+        free_.clear();
+        pending_.clear();
+        current_ = -1;
+        return ok;
+    }
+
+    bool failed() const { return failed_; }
+
+    OMTAsyncWriterStats stats()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        OMTAsyncWriterStats s = {};
+        s.bytesWritten = bytesWritten_;
+        s.chunksWritten = chunksWritten_;
+        s.stalls = stalls_;
+        s.stallMicroseconds = stallMicroseconds_;
+        s.inFlight = inFlight_;
+        return s;
+    }
+
+private:
+    struct Chunk
+    {
+        uint8_t* data;
+        size_t length;          // Bytes to write, a whole number of blocks with direct
+        uint64_t offset;        // Where in the file
+    };
+
+    OMTAsyncWriter(const OMTAsyncWriter&);
+    OMTAsyncWriter& operator=(const OMTAsyncWriter&);
+
+    // Makes sure there is a chunk to fill, waiting for one to come back if necessary
+    bool takeChunk()
+    {
+        if (current_ >= 0)
+        {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+#ifdef OMT_ASYNC_WRITER_IO_URING
+        reapCompleted();
+#endif
+        if (free_.empty())
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            while (free_.empty() && !failed_)
+            {
+                waitForChunk(lock);
+            }
+            stalls_++;
+            stallMicroseconds_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (free_.empty())
+        {
+            return false;
+        }
+        current_ = free_.back();
+        free_.pop_back();
+        fill_ = 0;
+        return true;
+    }
+
+    // Hands the current chunk to the background. Only the last chunk of a file is ever partial.
+    void submit()
+    {
+        Chunk& chunk = chunks_[current_];
+        chunk.length = fill_;
+        if (options_.direct && chunk.length % kBlock)
+        {
+            size_t whole = (chunk.length + kBlock - 1) / kBlock * kBlock;
+            memset(chunk.data + chunk.length, 0, whole - chunk.length);
+            chunk.length = whole;
+        }
+        chunk.offset = filePosition_;
+        filePosition_ += fill_;
+        int index = current_;
+        current_ = -1;
+        fill_ = 0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        inFlight_++;
+#ifdef OMT_ASYNC_WRITER_IO_URING
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        io_uring_prep_write(sqe, fd_, chunk.data, (unsigned)chunk.length, (off_t)chunk.offset);
+        io_uring_sqe_set_data(sqe, (void*)(intptr_t)index);
+        io_uring_submit(&ring_);
+#else
+        pending_.push_back(index);
+        queued_.notify_one();
+#endif
+    }
+
+    // Called with the lock held; returns once at least one chunk may have come back
+    void waitForChunk(std::unique_lock<std::mutex>& lock)
+    {
+#ifdef OMT_ASYNC_WRITER_IO_URING
+        // There is no other thread; reap a completion here. A short write is finished synchronously.
+        struct io_uring_cqe* cqe = NULL;
+        if (io_uring_wait_cqe(&ring_, &cqe) != 0)
+        {
+            failed_ = true;
+            inFlight_ = 0;
+            return;
+        }
+        int index = (int)(intptr_t)io_uring_cqe_get_data(cqe);
+        int result = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+        finishWrite(index, result);
+        (void)lock;
+#else
+        returned_.wait(lock);
+#endif
+    }
+
+#ifdef OMT_ASYNC_WRITER_IO_URING
+    // Takes back chunks whose writes have finished without waiting for more. Called with the lock held.
+    void reapCompleted()
+    {
+        struct io_uring_cqe* cqe = NULL;
+        while (inFlight_ > 0 && io_uring_peek_cqe(&ring_, &cqe) == 0 && cqe)
+        {
+            int index = (int)(intptr_t)io_uring_cqe_get_data(cqe);
+            int result = cqe->res;
+            io_uring_cqe_seen(&ring_, cqe);
+            finishWrite(index, result);
+        }
+    }
+
+    void finishWrite(int index, int result)
+    {
+        Chunk& chunk = chunks_[index];
+        bool ok = result >= 0 && ((size_t)result == chunk.length ||
+                  pwriteAll(chunk.data + result, chunk.length - result, chunk.offset + result));
+        completed(index, ok);
+    }
+#endif
+
+    // Called with the lock held
+    void completed(int index, bool ok)
+    {
+        if (ok)
+        {
+            bytesWritten_ += chunks_[index].length;
+            chunksWritten_++;
+        }
+        else
+        {
+            failed_ = true;
+        }
+        free_.push_back(index);
+        inFlight_--;
+    }
+
+    bool pwriteAll(const uint8_t* data, size_t length, uint64_t offset)
+    {
+        while (length > 0)
+        {
+            ssize_t n = pwrite(fd_, data, length, (off_t)offset);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+            data += n;
+            length -= (size_t)n;
+            offset += (uint64_t)n;
+        }
+        return true;
+    }
+
+#ifndef OMT_ASYNC_WRITER_IO_URING
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            while (pending_.empty() && !stopping_)
+            {
+                queued_.wait(lock);
+            }
+            if (pending_.empty())
+            {
+                return;
+            }
+            int index = pending_.front();
+            pending_.pop_front();
+            lock.unlock();
+            Chunk& chunk = chunks_[index];
+            bool ok = pwriteAll(chunk.data, chunk.length, chunk.offset);
+            lock.lock();
+            completed(index, ok);
+            returned_.notify_all();
+        }
+    }
+#endif
+
+    OMTAsyncWriterOptions options_;
+    int fd_;
+    std::vector<Chunk> chunks_;
+    int current_;                   // Chunk being filled by the caller, -1 for none
+    size_t fill_;
+    uint64_t position_;             // Logical end of the file
+    uint64_t filePosition_;         // Offset of the next chunk submitted
+
+    // Shared with the writer thread (or the completion path) under mutex_
+    std::mutex mutex_;
+    std::vector<int> free_;
+    std::deque<int> pending_;
+    std::atomic<bool> failed_;      // Also read by the caller without the lock
+    bool stopping_;
+    uint64_t bytesWritten_;
+    uint64_t chunksWritten_;
+    uint64_t stalls_;
+    uint64_t stallMicroseconds_;
+    int inFlight_;
+    std::condition_variable queued_;
+    std::condition_variable returned_;
+    std::thread thread_;
+#ifdef OMT_ASYNC_WRITER_IO_URING
+    struct io_uring ring_;
+#endif
+};
@@ -0,0 +1,270 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_audio_generator.h produces test signals directly into FPA1 (32-bit float planar) buffers
+	for any number of channels: white and pink noise, a line-up tone and a logarithmic sweep.
+
+	Noise comes from eight interleaved xorshift32 generators per channel, stepped four at a time
+	with SSE2 where available and as plain loops the compiler can vectorize elsewhere. Tones and
+	sweeps use a 32-bit phase accumulator into an interpolated sine table. Each generator owns its
+	state, so one per sender or thread needs no locking.  */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OMT_AUDIO_GENERATOR_SSE2 1
+#endif
+
+enum OMTAudioSignal
+{
+    OMTAudioSignal_Silence,
+    OMTAudioSignal_WhiteNoise,
+    OMTAudioSignal_PinkNoise,
+    OMTAudioSignal_Tone,
+    OMTAudioSignal_Sweep
+};
+
+struct OMTAudioGeneratorOptions
+{
+    OMTAudioSignal signal = OMTAudioSignal_WhiteNoise;
+    int channels = 2;
+    int sampleRate = 48000;
+
+    // Peak level, linear. 0.125 is the -18 dBFS EBU line-up level.
+    float level = 1.0f;
+
+    // Tone frequency in Hz
+    float frequency = 1000.0f;
+
+    // Sweep range in Hz and the time one sweep takes before it starts again
+    float sweepStart = 20.0f;
+    float sweepEnd = 20000.0f;
+    float sweepSeconds = 10.0f;
+
+    uint32_t seed = 0x12345678;
+};
+
+class OMTAudioGenerator
+{
+public:
+    static const int kLanes = 8;
+
+    explicit OMTAudioGenerator(const OMTAudioGeneratorOptions& options)
+        : options_(options), channels_(options.channels > 0 ? options.channels : 1)
+    {
+        state_.resize((size_t)channels_ * kLanes);
+        pink_.resize((size_t)channels_ * 3, 0.0f);
+
+        // Distinct non-zero seeds per lane, spread with splitmix32
+        uint32_t x = options_.seed;
+        for (size_t i = 0; i < state_.size(); i++)
+        {
+            x += 0x9E3779B9u;
+            uint32_t z = x;
+            z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+            z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+            z ^= z >> 16;
+            state_[i] = z ? z : 1;
+        }
+
+        for (int i = 0; i <= kTableSize; i++)
+        {
+            table_[i] = (float)sin(2.0 * 3.14159265358979323846 * i / kTableSize);
+        }
+        phase_ = 0;
+        increment_ = frequencyToIncrement(options_.signal == OMTAudioSignal_Sweep ? options_.sweepStart : options_.frequency);
+        sweepIncrement_ = increment_;
+        sweepFactor_ = 1.0;
+        if (options_.sweepSeconds > 0 && options_.sweepStart > 0 && options_.sweepEnd > 0)
+        {
+            sweepFactor_ = pow((double)options_.sweepEnd / options_.sweepStart, 1.0 / (options_.sweepSeconds * options_.sampleRate));
+        }
+    }
+
+    int channels() const { return channels_; }
+
+    // Fills samplesPerChannel samples of every channel. Channel c starts at planar + c * samplesPerChannel.
+    void render(float* planar, int samplesPerChannel)
+    {
+        switch (options_.signal)
+        {
+        case OMTAudioSignal_Silence:
+            memset(planar, 0, sizeof(float) * samplesPerChannel * channels_);
+            break;
+        case OMTAudioSignal_WhiteNoise:
+            for (int c = 0; c < channels_; c++)
+            {
+                noise(c, planar + (size_t)c * samplesPerChannel, samplesPerChannel, options_.level);
+            }
+            break;
+        case OMTAudioSignal_PinkNoise:
+            for (int c = 0; c < channels_; c++)
+            {
+                float* out = planar + (size_t)c * samplesPerChannel;
+                noise(c, out, samplesPerChannel, 1.0f);
+                pinkFilter(c, out, samplesPerChannel);
+            }
+            break;
+        case OMTAudioSignal_Tone:
+        case OMTAudioSignal_Sweep:
+            oscillator(planar, samplesPerChannel);
+            for (int c = 1; c < channels_; c++)
+            {
+                memcpy(planar + (size_t)c * samplesPerChannel, planar, sizeof(float) * samplesPerChannel);
+            }
+            break;
+        }
+    }
+
+private:
+    static const int kTableBits = 12;
+    static const int kTableSize = 1 << kTableBits;
+
+    uint32_t frequencyToIncrement(double frequency) const
+    {
+        return (uint32_t)(frequency / options_.sampleRate * 4294967296.0);
+    }
+
+    // Uniform noise in [-level, level) from the channel's lanes
+    void noise(int channel, float* out, int samples, float level)
+    {
+        uint32_t* lanes = &state_[(size_t)channel * kLanes];
+        int i = 0;
+#ifdef OMT_AUDIO_GENERATOR_SSE2
+        __m128i s0 = _mm_loadu_si128((const __m128i*)lanes);
+        __m128i s1 = _mm_loadu_si128((const __m128i*)(lanes + 4));
+        const __m128i one = _mm_set1_epi32(0x3F800000);
+        const __m128 scale = _mm_set1_ps(2.0f * level);
+        const __m128 offset = _mm_set1_ps(3.0f * level);
+        for (; i + kLanes <= samples; i += kLanes)
+        {
+            s0 = xorshift(s0);
+            s1 = xorshift(s1);
+            // Top 23 bits as the mantissa of a float in [1, 2), then mapped to [-level, level)
+            __m128 f0 = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(s0, 9), one));
+            __m128 f1 = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(s1, 9), one));
+            _mm_storeu_ps(out + i, _mm_sub_ps(_mm_mul_ps(f0, scale), offset));
+            _mm_storeu_ps(out + i + 4, _mm_sub_ps(_mm_mul_ps(f1, scale), offset));
+        }
+        _mm_storeu_si128((__m128i*)lanes, s0);
+        _mm_storeu_si128((__m128i*)(lanes + 4), s1);
+#endif
+        for (; i < samples; i += kLanes)
+        {
+            int count = (samples - i < kLanes) ? samples - i : kLanes;
+            for (int l = 0; l < kLanes; l++)
+            {
+                uint32_t x = lanes[l];
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                lanes[l] = x;
+                if (l < count)
+                {
+                    uint32_t bits = (x >> 9) | 0x3F800000u;
+                    float f;
+                    memcpy(&f, &bits, sizeof(f));
+                    out[i + l] = (f * 2.0f - 3.0f) * level;
+                }
+            }
+        }
+    }
+
+#ifdef OMT_AUDIO_GENERATOR_SSE2
+    static __m128i xorshift(__m128i x)
+    {
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    }
+#endif
+
+    // Paul Kellet's economy pink filter: three one-pole stages, accurate to about 0.5 dB above 9 Hz
+    void pinkFilter(int channel, float* out, int samples)
+    {
+        float* b = &pink_[(size_t)channel * 3];
+        float b0 = b[0], b1 = b[1], b2 = b[2];
+        // Peaks of the filtered noise stay below level in practice, but the filter can reach about
+        // 5.8 times that on a long run of same-signed input, so the rare excursion is clipped
+        const float level = options_.level;
+        const float gain = level * 0.11f;
+        for (int i = 0; i < samples; i++)
+        {
+            float white = out[i];
+            b0 = 0.99765f * b0 + white * 0.0990460f;
+            b1 = 0.96300f * b1 + white * 0.2965164f;
+            b2 = 0.57000f * b2 + white * 1.0526913f;
+            float pink = (b0 + b1 + b2 + white * 0.1848f) * gain;
+            out[i] = pink > level ? level : (pink < -level ? -level : pink);
+        }
+        b[0] = b0;
+        b[1] = b1;
+        b[2] = b2;
+    }
+
+    void oscillator(float* out, int samples)
+    {
+        const float level = options_.level;
+        const float fractionScale = 1.0f / (1 << (32 - kTableBits));
+        uint32_t phase = phase_;
+        uint32_t increment = increment_;
+        bool sweep = options_.signal == OMTAudioSignal_Sweep;
+        for (int i = 0; i < samples; i++)
+        {
+            uint32_t index = phase >> (32 - kTableBits);
+            float fraction = (float)(phase & ((1u << (32 - kTableBits)) - 1)) * fractionScale;
+            out[i] = (table_[index] + (table_[index + 1] - table_[index]) * fraction) * level;
+            phase += increment;
+            if (sweep)
+            {
+                sweepIncrement_ *= sweepFactor_;
+                if (sweepIncrement_ >= frequencyToIncrement(options_.sweepEnd))
+                {
+                    sweepIncrement_ = frequencyToIncrement(options_.sweepStart);
+                }
+                increment = (uint32_t)sweepIncrement_;
+            }
+        }
+        phase_ = phase;
+        increment_ = increment;
+    }
+
+    OMTAudioGeneratorOptions options_;
+    int channels_;
+    std::vector<uint32_t> state_;   // kLanes xorshift32 states per channel
+    std::vector<float> pink_;       // Three filter stages per channel
+    float table_[kTableSize + 1];
+    uint32_t phase_;
+    uint32_t increment_;
+    double sweepIncrement_;
+    double sweepFactor_;
+};
@@ -0,0 +1,483 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_clip_source.h plays a video clip from a memory mapped file, frame by frame and looping.
+
+	Raw files hold back to back frames in one of the OMT pixel formats (UYVY, YUY2, BGRA, UYVA,
+	NV12, YV12, P216, PA16); the format and size are given by the caller. Y4M files describe
+	themselves. Raw frames are returned as pointers into the mapping so they can be passed to
+	omt_send without a copy. Y4M stores 4:2:0 as Y,U,V and 4:2:2 as planes, which OMT does not
+	take directly, so those frames are rewritten into YV12 or UYVY in a pooled buffer.
+
+	The file is read ahead one frame at a time and frames already played are dropped from the
+	mapping, so long 4K clips play without being held in memory.
+
+	Include libomt.h before this header.  */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "omt_frame_pool.h"
+
+class OMTClipSource
+{
+public:
+    explicit OMTClipSource(OMTFramePool& pool)
+        : pool_(pool), map_(nullptr), mapLength_(0), pageSize_((size_t)sysconf(_SC_PAGESIZE)) { reset(); }
+
+    ~OMTClipSource() { close(); }
+
+    // Size in bytes of one frame of a raw file, 0 for formats a clip cannot hold.
+    static size_t rawFrameLength(uint32_t codec, int width, int height, int& stride)
+    {
+        size_t pixels = (size_t)width * height;
+        switch (codec)
+        {
+        case OMTCodec_UYVY:
+        case OMTCodec_YUY2:
+            stride = width * 2;
+            return pixels * 2;
+        case OMTCodec_UYVA:
+            stride = width * 2;
+            return pixels * 3;
+        case OMTCodec_BGRA:
+            stride = width * 4;
+            return pixels * 4;
+        case OMTCodec_NV12:
+        case OMTCodec_YV12:
+            stride = width;
+            return pixels * 3 / 2;
+        case OMTCodec_P216:
+            stride = width * 2;
+            return pixels * 4;
+        case OMTCodec_PA16:
+            stride = width * 2;
+            return pixels * 6;
+        default:
+            stride = 0;
+            return 0;
+        }
+    }
+
+    // Opens a raw clip of the given format and size. A trailing partial frame is ignored.
+    bool openRaw(const char* path, uint32_t codec, int width, int height, std::string& error)
+    {
+        close();
+        if (width <= 0 || height <= 0 || (width & 1))
+        {
+            error = "invalid frame size";
+            return false;
+        }
+        frameLength_ = rawFrameLength(codec, width, height, stride_);
+        if (frameLength_ == 0)
+        {
+            error = "unsupported pixel format";
+            return false;
+        }
+        if (!mapFile(path, error))
+        {
+            return false;
+        }
+        if (mapLength_ < frameLength_)
+        {
+            error = "file is smaller than one frame";
+            close();
+            return false;
+        }
+        if (mapLength_ % frameLength_ != 0)
+        {
+            fprintf(stderr, "OMTClipSource: %s is not a whole number of %dx%d frames, ignoring %zu trailing bytes\n",
+                    path, width, height, (size_t)(mapLength_ % frameLength_));
+        }
+        codec_ = codec;
+        width_ = width;
+        height_ = height;
+        frameCount_ = (int)(mapLength_ / frameLength_);
+        return true;
+    }
+
+    // Opens a YUV4MPEG2 clip. 4:2:0 clips play as YV12, 4:2:2 clips as UYVY.
+    bool openY4m(const char* path, std::string& error)
+    {
+        close();
+        if (!mapFile(path, error))
+        {
+            return false;
+        }
+        if (!parseY4mHeader(error))
+        {
+            close();
+            return false;
+        }
+        int stride;
+        frameLength_ = rawFrameLength(codec_, width_, height_, stride);
+        stride_ = stride;
+        convert_ = (uint8_t*)pool_.acquire(codec_, width_, height_, stride_, frameLength_);
+        if (!convert_)
+        {
+            error = "out of memory";
+            close();
+            return false;
+        }
+        // Encoders write bare "FRAME" headers; the count is approximate if frames carry parameters
+        frameCount_ = (int)((mapLength_ - firstFrame_) / (y4mFrameBytes_ + 6));
+        if (frameCount_ == 0)
+        {
+            error = "file holds no complete frame";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Picks the reader from the file name: .y4m files describe themselves, anything else is raw.
+    bool open(const char* path, uint32_t codec, int width, int height, std::string& error)
+    {
+        size_t len = strlen(path);
+        if (len > 4 && !strcasecmp(path + len - 4, ".y4m"))
+        {
+            return openY4m(path, error);
+        }
+        return openRaw(path, codec, width, height, error);
+    }
+
+    void close()
+    {
+        if (map_)
+        {
+            munmap(map_, mapLength_);
+        }
+        pool_.release(convert_);
+        reset();
+    }
+
+    // Returns the next frame, wrapping to the first after the last. The pointer stays valid
+    // until the following call; nullptr if nothing is open or a Y4M frame header is corrupt.
+    const void* nextFrame()
+    {
+        if (!map_)
+        {
+            return nullptr;
+        }
+        size_t offset = position_;
+        const uint8_t* frame;
+        if (convert_)
+        {
+            if (!nextY4mFrame(offset))
+            {
+                return nullptr;
+            }
+            frame = convert_;
+        }
+        else
+        {
+            if (offset + frameLength_ > mapLength_)
+            {
+                offset = 0;
+            }
+            position_ = offset + frameLength_;
+            frame = map_ + offset;
+        }
+
+        // Frames are handed over in order, so the one before this has been sent and its pages can go
+        if (previous_ != (size_t)-1 && previous_ != offset)
+        {
+            adviseRange(previous_, lastSpan_, MADV_DONTNEED);
+        }
+        lastSpan_ = convert_ ? (position_ - offset) : frameLength_;
+        previous_ = offset;
+
+        size_t ahead = (position_ + frameLength_ <= mapLength_) ? position_ : firstFrame_;
+        adviseRange(ahead, frameLength_ + 64, MADV_WILLNEED);
+        return frame;
+    }
+
+    uint32_t codec() const { return codec_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int stride() const { return stride_; }
+    int frameLength() const { return (int)frameLength_; }
+    int frameCount() const { return frameCount_; }
+
+    // Frame rate from a Y4M header, 0/0 for raw clips
+    int frameRateN() const { return frameRateN_; }
+    int frameRateD() const { return frameRateD_; }
+
+private:
+    enum Y4mChroma
+    {
+        Y4mChroma_420,
+        Y4mChroma_422
+    };
+
+    void reset()
+    {
+        map_ = nullptr;
+        mapLength_ = 0;
+        convert_ = nullptr;
+        codec_ = 0;
+        width_ = 0;
+        height_ = 0;
+        stride_ = 0;
+        frameLength_ = 0;
+        frameCount_ = 0;
+        frameRateN_ = 0;
+        frameRateD_ = 0;
+        firstFrame_ = 0;
+        position_ = 0;
+        previous_ = (size_t)-1;
+        lastSpan_ = 0;
+        y4mFrameBytes_ = 0;
+        y4mChroma_ = Y4mChroma_420;
+    }
+
+    bool mapFile(const char* path, std::string& error)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            error = std::string("cannot open ") + path;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            error = "cannot size file";
+            ::close(fd);
+            return false;
+        }
+        void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED)
+        {
+            error = "mmap failed";
+            return false;
+        }
+        map_ = (uint8_t*)map;
+        mapLength_ = (size_t)st.st_size;
+        madvise(map_, mapLength_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    // Applies advice to the whole pages inside [offset, offset + length)
+    void adviseRange(size_t offset, size_t length, int advice)
+    {
+        if (offset >= mapLength_)
+        {
+            return;
+        }
+        if (length > mapLength_ - offset)
+        {
+            length = mapLength_ - offset;
+        }
+        size_t begin = offset & ~(pageSize_ - 1);
+        size_t end = offset + length;
+        if (advice == MADV_DONTNEED)
+        {
+            // Never drop a page shared with a neighbouring frame
+            begin = (offset + pageSize_ - 1) & ~(pageSize_ - 1);
+            end &= ~(pageSize_ - 1);
+        }
+        if (end > begin)
+        {
+            madvise(map_ + begin, end - begin, advice);
+        }
+    }
+
+    bool parseY4mHeader(std::string& error)
+    {
+        static const char magic[] = "YUV4MPEG2 ";
+        const char* header = (const char*)map_;
+        const char* newline = (const char*)memchr(map_, '\n', mapLength_ < 4096 ? mapLength_ : 4096);
+        if (mapLength_ < sizeof(magic) || memcmp(header, magic, sizeof(magic) - 1) || !newline)
+        {
+            error = "not a YUV4MPEG2 file";
+            return false;
+        }
+
+        std::string chroma = "420";
+        const char* p = header + sizeof(magic) - 1;
+        while (p < newline)
+        {
+            while (p < newline && *p == ' ')
+            {
+                p++;
+            }
+            const char* end = p;
+            while (end < newline && *end != ' ')
+            {
+                end++;
+            }
+            if (end > p)
+            {
+                std::string value(p + 1, end);
+                switch (*p)
+                {
+                case 'W':
+                    width_ = atoi(value.c_str());
+                    break;
+                case 'H':
+                    height_ = atoi(value.c_str());
+                    break;
+                case 'F':
+                    sscanf(value.c_str(), "%d:%d", &frameRateN_, &frameRateD_);
+                    break;
+                case 'C':
+                    chroma = value;
+                    break;
+                }
+            }
+            p = end;
+        }
+
+        if (width_ <= 0 || height_ <= 0 || (width_ & 1) || (height_ & 1))
+        {
+            error = "unsupported Y4M frame size";
+            return false;
+        }
+        size_t pixels = (size_t)width_ * height_;
+        if (chroma.find("p1") != std::string::npos || chroma == "mono16")
+        {
+            // 420p10, 422p12 and the like: two bytes per sample
+            error = "unsupported Y4M chroma " + chroma + " (high bit depth; 8-bit 4:2:0 and 4:2:2 only)";
+            return false;
+        }
+        // The 4:2:0 variants differ only in chroma siting, which is not carried through
+        if (chroma == "420" || chroma == "420jpeg" || chroma == "420paldv" || chroma == "420mpeg2")
+        {
+            y4mChroma_ = Y4mChroma_420;
+            codec_ = OMTCodec_YV12;
+            y4mFrameBytes_ = pixels * 3 / 2;
+        }
+        else if (chroma == "422")
+        {
+            y4mChroma_ = Y4mChroma_422;
+            codec_ = OMTCodec_UYVY;
+            y4mFrameBytes_ = pixels * 2;
+        }
+        else
+        {
+            error = "unsupported Y4M chroma " + chroma + " (8-bit 4:2:0 and 4:2:2 only)";
+            return false;
+        }
+        if (frameRateN_ <= 0 || frameRateD_ <= 0)
+        {
+            frameRateN_ = 0;
+            frameRateD_ = 0;
+        }
+        firstFrame_ = (size_t)(newline - header) + 1;
+        position_ = firstFrame_;
+        return true;
+    }
+
+    // Reads the Y4M frame at position_ (or the first one after the end) into convert_
+    bool nextY4mFrame(size_t& offset)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            offset = position_;
+            const uint8_t* p = map_ + offset;
+            size_t left = mapLength_ - offset;
+            const uint8_t* newline = (left > 5) ? (const uint8_t*)memchr(p, '\n', left < 1024 ? left : 1024) : nullptr;
+            if (newline && !memcmp(p, "FRAME", 5) && (size_t)(newline + 1 - p) + y4mFrameBytes_ <= left)
+            {
+                const uint8_t* planes = newline + 1;
+                position_ = (size_t)(planes - map_) + y4mFrameBytes_;
+                convertY4m(planes);
+                return true;
+            }
+            if (offset == firstFrame_)
+            {
+                break;
+            }
+            // End of file or a truncated last frame: start over
+            position_ = firstFrame_;
+        }
+        return false;
+    }
+
+    void convertY4m(const uint8_t* planes)
+    {
+        size_t pixels = (size_t)width_ * height_;
+        if (y4mChroma_ == Y4mChroma_420)
+        {
+            // Y4M is Y,U,V; YV12 is Y,V,U
+            size_t chroma = pixels / 4;
+            memcpy(convert_, planes, pixels);
+            memcpy(convert_ + pixels, planes + pixels + chroma, chroma);
+            memcpy(convert_ + pixels + chroma, planes + pixels, chroma);
+            return;
+        }
+
+        // Planar 4:2:2 to packed UYVY
+        const uint8_t* y = planes;
+        const uint8_t* u = planes + pixels;
+        const uint8_t* v = u + pixels / 2;
+        uint8_t* out = convert_;
+        for (size_t i = 0; i < pixels / 2; i++)
+        {
+            out[0] = u[i];
+            out[1] = y[2 * i];
+            out[2] = v[i];
+            out[3] = y[2 * i + 1];
+            out += 4;
+        }
+    }
+
+    OMTClipSource(const OMTClipSource&);
+    OMTClipSource& operator=(const OMTClipSource&);
+
+    OMTFramePool& pool_;
+    uint8_t* map_;
+    size_t mapLength_;
+    size_t pageSize_;
+    uint8_t* convert_;          // Conversion buffer for Y4M, null for raw clips
+    uint32_t codec_;
+    int width_;
+    int height_;
+    int stride_;
+    size_t frameLength_;
+    int frameCount_;
+    int frameRateN_;
+    int frameRateD_;
+    size_t firstFrame_;         // Offset of the first frame (Y4M header length, 0 for raw)
+    size_t position_;           // Offset of the next frame to read
+    size_t previous_;           // Offset of the frame returned last
+    size_t lastSpan_;           // Bytes of the mapping the last frame used
+    size_t y4mFrameBytes_;
+    Y4mChroma y4mChroma_;
+};
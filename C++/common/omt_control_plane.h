@@ -0,0 +1,195 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_control_plane.h takes the control side of an OMT sender off the media thread: tally,
+	metadata sent back by receivers, connection count and statistics.
+
+	OMTSendControl waits in omt_send_receive and omt_send_gettally with real timeouts instead of
+	polling them with 0, and publishes what it learns as a snapshot that any thread can read
+	without locking. It either runs its own thread (start/stop) or is driven by poll() from a
+	thread the application already has.
+
+	Include libomt.h before this header.  */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+// Single writer, many reader snapshot of a trivially copyable value. Readers never block the
+// writer; a read that overlaps a write is retried.
+template <typename T>
+class OMTSeqlock
+{
+public:
+    OMTSeqlock() : sequence_(0) { memset(&value_, 0, sizeof(value_)); }
+
+    void store(const T& value)
+    {
+        uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&value_, &value, sizeof(T));
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        T value;
+        uint32_t before, after;
+        do
+        {
+            before = sequence_.load(std::memory_order_acquire);
+            memcpy(&value, &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> sequence_;
+    T value_;
+};
+
+struct OMTSendControlSnapshot
+{
+    uint64_t updates;            // Increments each time the snapshot is republished
+    OMTTally tally;
+    uint64_t tallyChanges;
+    int connections;
+    OMTStatistics video;
+    OMTStatistics audio;
+    uint64_t metadataFrames;     // Metadata frames received from receivers so far
+    char lastMetadata[1024];     // The latest of them, truncated and null terminated
+};
+
+class OMTSendControl
+{
+public:
+    // waitMilliseconds bounds each blocking call, and so how long stop() can take.
+    explicit OMTSendControl(omt_send_t* sender, int waitMilliseconds = 50, int statisticsMilliseconds = 1000)
+        : sender_(sender), wait_(waitMilliseconds), statisticsInterval_(statisticsMilliseconds), running_(false)
+    {
+        memset(&current_, 0, sizeof(current_));
+    }
+
+    ~OMTSendControl() { stop(); }
+
+    // Called on the control thread for every metadata frame a receiver sends back
+    void setMetadataHandler(const std::function<void(const char* xml, int length)>& handler) { metadataHandler_ = handler; }
+
+    void start()
+    {
+        if (running_)
+        {
+            return;
+        }
+        running_ = true;
+        thread_ = std::thread([this]
+        {
+            while (running_)
+            {
+                poll();
+            }
+        });
+    }
+
+    void stop()
+    {
+        running_ = false;
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    // One round of control work: waits up to the timeout each for metadata and a tally change, and
+    // refreshes connections and statistics once per interval. Only call from one thread at a time.
+    void poll()
+    {
+        bool changed = false;
+
+        OMTMediaFrame* metadata = omt_send_receive(sender_, wait_);
+        if (metadata && metadata->Data && metadata->DataLength > 0)
+        {
+            size_t length = (size_t)metadata->DataLength;
+            if (length > sizeof(current_.lastMetadata) - 1)
+            {
+                length = sizeof(current_.lastMetadata) - 1;
+            }
+            memcpy(current_.lastMetadata, metadata->Data, length);
+            current_.lastMetadata[length] = 0;
+            current_.metadataFrames++;
+            changed = true;
+            if (metadataHandler_)
+            {
+                metadataHandler_((const char*)metadata->Data, metadata->DataLength);
+            }
+        }
+
+        if (omt_send_gettally(sender_, wait_, &current_.tally))
+        {
+            current_.tallyChanges++;
+            changed = true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (current_.updates == 0 || now - lastStatistics_ >= std::chrono::milliseconds(statisticsInterval_))
+        {
+            lastStatistics_ = now;
+            current_.connections = omt_send_connections(sender_);
+            omt_send_getvideostatistics(sender_, &current_.video);
+            omt_send_getaudiostatistics(sender_, &current_.audio);
+            changed = true;
+        }
+
+        if (changed)
+        {
+            current_.updates++;
+            published_.store(current_);
+        }
+    }
+
+    OMTSendControlSnapshot snapshot() const { return published_.load(); }
+
+private:
+    OMTSendControl(const OMTSendControl&);
+    OMTSendControl& operator=(const OMTSendControl&);
+
+    omt_send_t* sender_;
+    int wait_;
+    int statisticsInterval_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+    std::function<void(const char*, int)> metadataHandler_;
+    std::chrono::steady_clock::time_point lastStatistics_;
+    OMTSendControlSnapshot current_;     // Owned by the polling thread
+    OMTSeqlock<OMTSendControlSnapshot> published_;
+};
@@ -0,0 +1,285 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_frame_pool.h is a pool of buffers for OMTMediaFrame.Data, shared by the examples.
+
+	Buffers are grouped in size classes keyed by codec, width, height and stride, are 64-byte
+	aligned and are pre-faulted when first mapped. Released buffers are kept for reuse, so a
+	pipeline that acquires and releases the same shapes every frame stops allocating after the
+	first few frames. On Linux buffers can be backed by huge pages (MAP_HUGETLB, falling back to
+	transparent huge pages) and bound to a NUMA node.  */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+struct OMTFramePoolOptions
+{
+    // Back buffers with huge pages where the OS allows it
+    bool hugePages = false;
+
+    // Bind buffers to this NUMA node (Linux only), -1 to leave placement to the OS
+    int numaNode = -1;
+};
+
+struct OMTFramePoolStats
+{
+    uint64_t hits;            // acquires served from a released buffer
+    uint64_t misses;          // acquires that had to map a new buffer
+    uint64_t outstanding;     // buffers currently acquired
+    uint64_t residentBytes;   // bytes mapped by the pool, in use or cached
+    uint64_t hugePageBytes;   // part of residentBytes backed by MAP_HUGETLB
+    int sizeClasses;
+};
+
+class OMTFramePool
+{
+public:
+    static const size_t kAlignment = 64;
+
+    explicit OMTFramePool(const OMTFramePoolOptions& options = OMTFramePoolOptions())
+        : options_(options), hits_(0), misses_(0), outstanding_(0), residentBytes_(0), hugePageBytes_(0) {}
+
+    ~OMTFramePool()
+    {
+        // Buffers still acquired are leaked deliberately; their owners may still be using them
+        for (size_t i = 0; i < classes_.size(); i++)
+        {
+            for (size_t j = 0; j < classes_[i].free.size(); j++)
+            {
+                unmap(classes_[i].free[j]);
+            }
+        }
+    }
+
+    // Returns a buffer of at least length bytes for frames of this shape, or null if mapping failed.
+    // codec is the OMTCodec FourCC of the data.
+    void* acquire(uint32_t codec, int width, int height, int stride, size_t length)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SizeClass& sizeClass = findClass(codec, width, height, stride, length);
+        void* buffer;
+        if (!sizeClass.free.empty())
+        {
+            buffer = sizeClass.free.back();
+            sizeClass.free.pop_back();
+            hits_++;
+        }
+        else
+        {
+            buffer = map(sizeClass);
+            if (!buffer)
+            {
+                return nullptr;
+            }
+            // Make sure a release never has to grow the free list
+            sizeClass.free.reserve(sizeClass.mapped);
+            misses_++;
+        }
+        outstanding_++;
+        return buffer;
+    }
+
+    // Untyped buffers, e.g. compressed bitstreams. Lengths are rounded up to a power of two
+    // so that frames of varying size share a class.
+    void* acquireBytes(size_t length)
+    {
+        size_t rounded = 4096;
+        while (rounded < length)
+        {
+            rounded <<= 1;
+        }
+        return acquire(0, 0, 0, 0, rounded);
+    }
+
+    void release(void* buffer)
+    {
+        if (!buffer)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        BufferHeader* header = headerOf(buffer);
+        classes_[header->sizeClass].free.push_back(buffer);
+        outstanding_--;
+    }
+
+    OMTFramePoolStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        OMTFramePoolStats s = {};
+        s.hits = hits_;
+        s.misses = misses_;
+        s.outstanding = outstanding_;
+        s.residentBytes = residentBytes_;
+        s.hugePageBytes = hugePageBytes_;
+        s.sizeClasses = (int)classes_.size();
+        return s;
+    }
+
+private:
+    struct SizeClass
+    {
+        uint32_t codec;
+        int width;
+        int height;
+        int stride;
+        size_t length;
+        size_t mapped;
+        std::vector<void*> free;
+    };
+
+    // Sits in the 64 bytes in front of every buffer, keeping the data itself aligned
+    struct BufferHeader
+    {
+        void* base;
+        size_t mappedBytes;
+        int sizeClass;
+        bool hugePages;
+    };
+
+    static BufferHeader* headerOf(void* buffer)
+    {
+        return (BufferHeader*)((uint8_t*)buffer - kAlignment);
+    }
+
+    SizeClass& findClass(uint32_t codec, int width, int height, int stride, size_t length)
+    {
+        for (size_t i = 0; i < classes_.size(); i++)
+        {
+            SizeClass& c = classes_[i];
+            if (c.codec == codec && c.width == width && c.height == height && c.stride == stride && c.length >= length)
+            {
+                return c;
+            }
+        }
+        SizeClass c;
+        c.codec = codec;
+        c.width = width;
+        c.height = height;
+        c.stride = stride;
+        c.length = length;
+        c.mapped = 0;
+        classes_.push_back(c);
+        return classes_.back();
+    }
+
+    void* map(SizeClass& sizeClass)
+    {
+        size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        size_t bytes = sizeClass.length + kAlignment;
+        bool huge = false;
+        void* base = MAP_FAILED;
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+        if (options_.hugePages)
+        {
+            const size_t hugePageSize = 2 * 1024 * 1024;
+            size_t hugeBytes = (bytes + hugePageSize - 1) & ~(hugePageSize - 1);
+            base = mmap(NULL, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (base != MAP_FAILED)
+            {
+                bytes = hugeBytes;
+                huge = true;
+            }
+        }
+#endif
+        if (base == MAP_FAILED)
+        {
+            bytes = (bytes + pageSize - 1) & ~(pageSize - 1);
+            base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (base == MAP_FAILED)
+            {
+                return nullptr;
+            }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            // No reserved huge pages: ask for transparent huge pages instead
+            if (options_.hugePages)
+            {
+                madvise(base, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+
+#if defined(__linux__) && defined(SYS_mbind)
+        if (options_.numaNode >= 0 && options_.numaNode < 64)
+        {
+            const int MPOL_PREFERRED_MODE = 1;
+            unsigned long nodeMask = 1UL << options_.numaNode;
+            syscall(SYS_mbind, base, bytes, MPOL_PREFERRED_MODE, &nodeMask, 64 + 1, 0);
+        }
+#endif
+
+        // Fault every page in now (on the chosen node) rather than on the first frame
+        memset(base, 0, bytes);
+
+        BufferHeader* header = (BufferHeader*)base;
+        header->base = base;
+        header->mappedBytes = bytes;
+        header->sizeClass = (int)(&sizeClass - &classes_[0]);
+        header->hugePages = huge;
+
+        sizeClass.mapped++;
+        residentBytes_ += bytes;
+        if (huge)
+        {
+            hugePageBytes_ += bytes;
+        }
+        return (uint8_t*)base + kAlignment;
+    }
+
+    void unmap(void* buffer)
+    {
+        BufferHeader* header = headerOf(buffer);
+        residentBytes_ -= header->mappedBytes;
+        if (header->hugePages)
+        {
+            hugePageBytes_ -= header->mappedBytes;
+        }
+        munmap(header->base, header->mappedBytes);
+    }
+
+    OMTFramePool(const OMTFramePool&);
+    OMTFramePool& operator=(const OMTFramePool&);
+
+    OMTFramePoolOptions options_;
+    mutable std::mutex mutex_;
+    std::vector<SizeClass> classes_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t outstanding_;
+    uint64_t residentBytes_;
+    uint64_t hugePageBytes_;
+};
@@ -0,0 +1,164 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_frame_ring.h renders test frames that are a static background plus a few changing regions.
+
+	A small ring of output buffers is filled with the background once. Each buffer remembers the
+	byte ranges drawn into it; when it comes round again only those ranges are restored from the
+	background before the new ones are drawn. Memory traffic per frame is then proportional to
+	what changed rather than to the frame size.  */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "omt_frame_pool.h"
+
+class OMTFrameRing
+{
+public:
+    static const int kMaxBuffers = 4;
+    static const int kMaxRegions = 8;
+
+    // background must hold length bytes and stay valid for the lifetime of the ring.
+    OMTFrameRing(OMTFramePool& pool, uint32_t codec, int width, int height, int stride, size_t length,
+                 const void* background, int buffers = 3)
+        : pool_(pool), background_((const uint8_t*)background), length_(length), count_(0), current_(-1),
+          bytesWritten_(0)
+    {
+        if (buffers > kMaxBuffers)
+        {
+            buffers = kMaxBuffers;
+        }
+        for (int i = 0; i < buffers; i++)
+        {
+            Slot& slot = slots_[i];
+            slot.data = (uint8_t*)pool_.acquire(codec, width, height, stride, length);
+            slot.regions = 0;
+            if (!slot.data)
+            {
+                break;
+            }
+            memcpy(slot.data, background_, length_);
+            count_++;
+        }
+    }
+
+    ~OMTFrameRing()
+    {
+        for (int i = 0; i < count_; i++)
+        {
+            pool_.release(slots_[i].data);
+        }
+    }
+
+    // False if the pool could not provide any buffer
+    bool valid() const { return count_ > 0; }
+
+    // Moves to the next buffer in the ring and restores the regions drawn into it last time.
+    // Returns the buffer, which then holds the plain background, or NULL if the ring is not valid().
+    void* next()
+    {
+        if (count_ == 0)
+        {
+            return NULL;
+        }
+        current_ = (current_ + 1) % count_;
+        Slot& slot = slots_[current_];
+        for (int i = 0; i < slot.regions; i++)
+        {
+            memcpy(slot.data + slot.offset[i], background_ + slot.offset[i], slot.length[i]);
+            bytesWritten_ += slot.length[i];
+        }
+        slot.regions = 0;
+        return slot.data;
+    }
+
+    // Copies length bytes of src to offset in the current buffer and records the range as dirty.
+    // Ranges beyond the frame are clipped. Once kMaxRegions ranges are recorded further draws are
+    // merged into the last one.
+    void draw(size_t offset, const void* src, size_t length)
+    {
+        if (current_ < 0 || offset >= length_)
+        {
+            return;
+        }
+        if (length > length_ - offset)
+        {
+            length = length_ - offset;
+        }
+        Slot& slot = slots_[current_];
+        memcpy(slot.data + offset, src, length);
+        bytesWritten_ += length;
+
+        if (slot.regions < kMaxRegions)
+        {
+            slot.offset[slot.regions] = offset;
+            slot.length[slot.regions] = length;
+            slot.regions++;
+        }
+        else
+        {
+            size_t& lastOffset = slot.offset[kMaxRegions - 1];
+            size_t& lastLength = slot.length[kMaxRegions - 1];
+            size_t end = (offset + length > lastOffset + lastLength) ? offset + length : lastOffset + lastLength;
+            if (offset < lastOffset)
+            {
+                lastOffset = offset;
+            }
+            lastLength = end - lastOffset;
+        }
+    }
+
+    // Bytes restored and drawn since the last call, for comparing against a full frame copy
+    uint64_t takeBytesWritten()
+    {
+        uint64_t bytes = bytesWritten_;
+        bytesWritten_ = 0;
+        return bytes;
+    }
+
+private:
+    struct Slot
+    {
+        uint8_t* data;
+        int regions;
+        size_t offset[kMaxRegions];
+        size_t length[kMaxRegions];
+    };
+
+    OMTFrameRing(const OMTFrameRing&);
+    OMTFrameRing& operator=(const OMTFrameRing&);
+
+    OMTFramePool& pool_;
+    const uint8_t* background_;
+    size_t length_;
+    int count_;
+    int current_;
+    uint64_t bytesWritten_;
+    Slot slots_[kMaxBuffers];
+};
@@ -0,0 +1,217 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_histogram.h records values such as frame intervals and latencies in microseconds into a
+	fixed size histogram with bounded relative error, in the manner of HdrHistogram, and reports
+	percentiles from it.
+
+	Buckets are log-linear: each power of two is split into 2^subBucketBits equal sub-buckets, so
+	with the default of 7 any value is reported within 1/128 (0.8%) of what was recorded, from
+	microseconds to days, in about 35 KB. Recording is one relaxed atomic add, so a worker thread
+	can record while another thread drains the histogram for a periodic report.  */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+class OMTHistogram
+{
+public:
+    explicit OMTHistogram(int subBucketBits = 7, int maxValueBits = 40)
+        : subBucketBits_(subBucketBits), subBuckets_(1 << subBucketBits),
+          bucketCount_(((size_t)(maxValueBits - subBucketBits) + 2) << subBucketBits),
+          counts_(new std::atomic<uint64_t>[bucketCount_]), maxValue_((int64_t)1 << maxValueBits)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (size_t i = 0; i < bucketCount_; i++)
+        {
+            counts_[i].store(0, std::memory_order_relaxed);
+        }
+        total_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(INT64_MAX, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+        below_.store(0, std::memory_order_relaxed);
+    }
+
+    // Values below zero are counted separately (see below()) and values above the range are clamped
+    void record(int64_t value)
+    {
+        if (value < 0)
+        {
+            below_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (value >= maxValue_)
+        {
+            value = maxValue_ - 1;
+        }
+        counts_[index(value)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        int64_t current = min_.load(std::memory_order_relaxed);
+        while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+        current = max_.load(std::memory_order_relaxed);
+        while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Adds everything recorded here to target and clears this histogram. Values recorded
+    // concurrently land either in this drain or the next one. Both must have the same layout.
+    void drainInto(OMTHistogram& target)
+    {
+        for (size_t i = 0; i < bucketCount_; i++)
+        {
+            uint64_t n = counts_[i].exchange(0, std::memory_order_relaxed);
+            if (n)
+            {
+                target.counts_[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        target.total_.fetch_add(total_.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        target.sum_.fetch_add(sum_.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        target.below_.fetch_add(below_.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        int64_t low = min_.exchange(INT64_MAX, std::memory_order_relaxed);
+        int64_t high = max_.exchange(0, std::memory_order_relaxed);
+        if (low < target.min_.load(std::memory_order_relaxed))
+        {
+            target.min_.store(low, std::memory_order_relaxed);
+        }
+        if (high > target.max_.load(std::memory_order_relaxed))
+        {
+            target.max_.store(high, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds other's counts to this one without clearing it
+    void add(const OMTHistogram& other)
+    {
+        for (size_t i = 0; i < bucketCount_; i++)
+        {
+            counts_[i].fetch_add(other.counts_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        total_.fetch_add(other.count(), std::memory_order_relaxed);
+        sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        below_.fetch_add(other.below(), std::memory_order_relaxed);
+        if (other.count() && other.min() < min())
+        {
+            min_.store(other.min(), std::memory_order_relaxed);
+        }
+        if (other.max() > max())
+        {
+            max_.store(other.max(), std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t below() const { return below_.load(std::memory_order_relaxed); }
+    int64_t min() const { return count() ? min_.load(std::memory_order_relaxed) : 0; }
+    int64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? (double)sum_.load(std::memory_order_relaxed) / count() : 0; }
+
+    // Value at or below which the given percentage (0-100) of recorded values fall, reported as the
+    // middle of its bucket and never outside the recorded min and max
+    int64_t percentile(double percent) const
+    {
+        uint64_t total = count();
+        if (!total)
+        {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(percent / 100.0 * total + 0.5);
+        rank = rank < 1 ? 1 : (rank > total ? total : rank);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucketCount_; i++)
+        {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                int64_t value = lowest(i) + (width(i) - 1) / 2;
+                return value < min() ? min() : (value > max() ? max() : value);
+            }
+        }
+        return max();
+    }
+
+    // "n=<count> min p50 p90 p99 p99.9 max" with values divided by scale, e.g. 1000 for microseconds as ms
+    void format(char* text, size_t length, double scale) const
+    {
+        snprintf(text, length, "n=%llu min %.2f p50 %.2f p90 %.2f p99 %.2f p99.9 %.2f max %.2f",
+                 (unsigned long long)count(), min() / scale, percentile(50) / scale, percentile(90) / scale,
+                 percentile(99) / scale, percentile(99.9) / scale, max() / scale);
+    }
+
+private:
+    OMTHistogram(const OMTHistogram&);
+    OMTHistogram& operator=(const OMTHistogram&);
+
+    size_t index(int64_t value) const
+    {
+        uint64_t v = (uint64_t)value;
+        if (v < (uint64_t)subBuckets_ * 2)
+        {
+            return (size_t)v;
+        }
+        int exponent = 63 - __builtin_clzll(v) - subBucketBits_;
+        return ((size_t)exponent << subBucketBits_) + (size_t)(v >> exponent);
+    }
+
+    int64_t lowest(size_t index) const
+    {
+        if (index < (size_t)subBuckets_ * 2)
+        {
+            return (int64_t)index;
+        }
+        int exponent = (int)(index >> subBucketBits_) - 1;
+        int64_t mantissa = (int64_t)(index - ((size_t)exponent << subBucketBits_));
+        return mantissa << exponent;
+    }
+
+    int64_t width(size_t index) const
+    {
+        return index < (size_t)subBuckets_ * 2 ? 1 : (int64_t)1 << ((index >> subBucketBits_) - 1);
+    }
+
+    int subBucketBits_;
+    int subBuckets_;
+    size_t bucketCount_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    int64_t maxValue_;
+    std::atomic<uint64_t> total_;
+    std::atomic<int64_t> sum_;
+    std::atomic<int64_t> min_;
+    std::atomic<int64_t> max_;
+    std::atomic<uint64_t> below_;
+};
@@ -0,0 +1,195 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_latency_probe.h marks video frames with a sequence number and the wall clock time they were
+	sent, so a receiver can measure end to end latency and spot lost frames.
+
+	The mark travels two ways. Per frame metadata carries the full values as
+	<OMTProbe seq="..." sent="..."/>. A barcode of 64 black and white blocks across the top of the
+	picture carries the low 16 bits of the sequence, the low 40 bits of the send time in
+	microseconds and a check byte; the blocks are large enough to survive VMX compression at any
+	quality, so it measures the path through the encoder and decoder as well.
+
+	Times are in OMT timestamp units, 100 ns, since the Unix epoch. On one host the result is
+	exact; between hosts the clocks must be synchronised, for example with PTP.
+
+	The barcode is drawn into and read from UYVY, UYVA, P216, PA16 and BGRA frames.
+
+	Include libomt.h before this header.  */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static const int OMT_PROBE_BITS = 64;
+static const int OMT_PROBE_BLOCK_HEIGHT = 16;
+
+inline int64_t omtProbeNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 100;
+}
+
+// Writes the metadata form into text and returns FrameMetadataLength (including the null), or 0 if it does not fit
+inline int omtProbeWriteMetadata(char* text, size_t length, uint64_t sequence, int64_t sent)
+{
+    int written = snprintf(text, length, "<OMTProbe seq=\"%llu\" sent=\"%lld\"/>", (unsigned long long)sequence, (long long)sent);
+    return (written > 0 && (size_t)written < length) ? written + 1 : 0;
+}
+
+// Finds the probe element anywhere in a frame's metadata
+inline bool omtProbeReadMetadata(const void* metadata, int length, uint64_t& sequence, int64_t& sent)
+{
+    if (!metadata || length <= 0 || ((const char*)metadata)[length - 1] != 0)
+    {
+        return false;
+    }
+    const char* probe = strstr((const char*)metadata, "<OMTProbe ");
+    unsigned long long s;
+    long long t;
+    if (!probe || sscanf(probe, "<OMTProbe seq=\"%llu\" sent=\"%lld\"", &s, &t) != 2)
+    {
+        return false;
+    }
+    sequence = s;
+    sent = t;
+    return true;
+}
+
+// Block width used for a frame width; the barcode spans 64 of them from the left edge
+inline int omtProbeBlockWidth(int width)
+{
+    return (width / OMT_PROBE_BITS) & ~1;
+}
+
+inline uint64_t omtProbePack(uint64_t sequence, int64_t sent)
+{
+    uint64_t micros = (uint64_t)(sent / 10) & ((1ULL << 40) - 1);
+    uint64_t value = micros | ((sequence & 0xFFFF) << 40);
+    uint8_t check = 0xA5;
+    for (int i = 0; i < 7; i++)
+    {
+        check ^= (uint8_t)(value >> (i * 8));
+    }
+    return value | ((uint64_t)check << 56);
+}
+
+// Draws the barcode over the top OMT_PROBE_BLOCK_HEIGHT lines. Returns false for unsupported codecs or small frames.
+inline bool omtProbeDrawBarcode(void* data, uint32_t codec, int width, int height, int stride, uint64_t sequence, int64_t sent)
+{
+    int blockWidth = omtProbeBlockWidth(width);
+    if (blockWidth < 2 || height < OMT_PROBE_BLOCK_HEIGHT)
+    {
+        return false;
+    }
+    uint64_t value = omtProbePack(sequence, sent);
+    uint8_t* line = (uint8_t*)data;
+    for (int x = 0; x < OMT_PROBE_BITS * blockWidth; x++)
+    {
+        bool bit = (value >> (x / blockWidth)) & 1;
+        switch (codec)
+        {
+        case OMTCodec_UYVY:
+        case OMTCodec_UYVA:
+            line[x * 2] = 128;
+            line[x * 2 + 1] = bit ? 235 : 16;
+            break;
+        case OMTCodec_P216: // luma plane then a chroma plane of the same size
+        case OMTCodec_PA16:
+            ((uint16_t*)line)[x] = bit ? 60160 : 4096;
+            ((uint16_t*)(line + (size_t)stride * height))[x] = 32768;
+            break;
+        case OMTCodec_BGRA:
+            memset(line + x * 4, bit ? 255 : 0, 3);
+            line[x * 4 + 3] = 255;
+            break;
+        default:
+            return false;
+        }
+    }
+    size_t lineBytes = (size_t)(codec == OMTCodec_BGRA ? 4 : 2) * OMT_PROBE_BITS * blockWidth;
+    for (int y = 1; y < OMT_PROBE_BLOCK_HEIGHT; y++)
+    {
+        memcpy(line + (size_t)y * stride, line, lineBytes);
+        if (codec == OMTCodec_P216 || codec == OMTCodec_PA16)
+        {
+            uint8_t* chroma = line + (size_t)stride * height;
+            memcpy(chroma + (size_t)y * stride, chroma, (size_t)2 * OMT_PROBE_BITS * blockWidth);
+        }
+    }
+    return true;
+}
+
+// Reads the barcode and checks it. The 40 bit send time is placed in the 12 day window ending
+// shortly after now, which recovers the full time as long as the latency is below that.
+inline bool omtProbeReadBarcode(const void* data, uint32_t codec, int width, int height, int stride, uint16_t& sequence, int64_t& sent, int64_t now)
+{
+    int blockWidth = omtProbeBlockWidth(width);
+    if (!data || blockWidth < 2 || height < OMT_PROBE_BLOCK_HEIGHT)
+    {
+        return false;
+    }
+    uint64_t value = 0;
+    for (int bit = 0; bit < OMT_PROBE_BITS; bit++)
+    {
+        // Average the middle of the block, away from edges blurred by compression
+        int total = 0, samples = 0;
+        for (int y = OMT_PROBE_BLOCK_HEIGHT / 4; y < OMT_PROBE_BLOCK_HEIGHT * 3 / 4; y++)
+        {
+            const uint8_t* line = (const uint8_t*)data + (size_t)y * stride;
+            for (int x = bit * blockWidth + blockWidth / 4; x < bit * blockWidth + blockWidth * 3 / 4 + 1; x++)
+            {
+                switch (codec)
+                {
+                case OMTCodec_UYVY: case OMTCodec_UYVA: total += line[x * 2 + 1]; break;
+                case OMTCodec_P216: case OMTCodec_PA16: total += ((const uint16_t*)line)[x] >> 8; break;
+                case OMTCodec_BGRA: total += line[x * 4 + 1]; break;
+                default: return false;
+                }
+                samples++;
+            }
+        }
+        if (total > samples * 126)
+        {
+            value |= 1ULL << bit;
+        }
+    }
+    if (omtProbePack((value >> 40) & 0xFFFF, (int64_t)(value & ((1ULL << 40) - 1)) * 10) != value)
+    {
+        return false;
+    }
+    const int64_t window = 1LL << 40;
+    int64_t nowMicros = now / 10 + 1000000;
+    int64_t micros = (nowMicros & ~(window - 1)) | (int64_t)(value & (window - 1));
+    if (micros > nowMicros)
+    {
+        micros -= window;
+    }
+    sequence = (uint16_t)(value >> 40);
+    sent = micros * 10;
+    return true;
+}
@@ -0,0 +1,305 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_media_file.h reads and writes an indexed file of OMT frames, so compressed VMX1 video
+	captured once can be replayed through omt_send without encoding it again. Uncompressed video
+	(UYVY, P216 and the like) can be stored the same way; the header then records its stride.
+
+	Layout, all integers little endian:
+
+		OMTMediaFileHeader   (128 bytes)
+		frame payloads       (back to back, each starting on a 64 byte boundary)
+		OMTMediaFileEntry[]  (one per frame, at header.indexOffset)
+
+	The header and index are written when the file is closed; a file whose writer did not
+	finish has indexOffset 0 and is rejected by the reader. The writer goes through
+	OMTAsyncWriter, so the thread receiving frames only copies them into a buffer. The reader
+	maps the whole file and hands out pointers into the mapping; the index in memory gives any
+	frame's position directly.  */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "omt_async_writer.h"
+
+static const char OMT_MEDIA_FILE_MAGIC[8] = { 'O', 'M', 'T', 'M', 'E', 'D', 'I', 'A' };
+static const uint32_t OMT_MEDIA_FILE_VERSION = 1;
+static const size_t OMT_MEDIA_FILE_ALIGNMENT = 64;
+
+struct OMTMediaFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    // Video format of the VMX1 frames
+    int32_t width;
+    int32_t height;
+    int32_t frameRateN;
+    int32_t frameRateD;
+    float aspectRatio;
+    int32_t colorSpace;
+    int32_t videoFlags;         // OMTVideoFlags, e.g. HighBitDepth for 16-bit sources
+
+    // Audio format, 0 when the file holds no audio
+    int32_t sampleRate;
+    int32_t channels;
+
+    uint32_t frameCount;
+    uint64_t indexOffset;
+    int32_t stride;             // Stride of uncompressed video, 0 for VMX1
+    uint8_t reserved[60];
+};
+
+struct OMTMediaFileEntry
+{
+    uint64_t offset;            // Payload position from the start of the file
+    int64_t timestamp;          // Timestamp of the frame as received
+    uint32_t length;            // Payload bytes
+    uint32_t type;              // OMTFrameType
+    uint32_t codec;             // OMTCodec
+    uint32_t info;              // Video: OMTVideoFlags. Audio: samples per channel.
+};
+
+static_assert(sizeof(OMTMediaFileHeader) == 128, "OMTMediaFileHeader is part of the file format");
+static_assert(sizeof(OMTMediaFileEntry) == 32, "OMTMediaFileEntry is part of the file format");
+
+// Not thread safe; a recorder writing video and audio from two threads serialises the calls
+class OMTMediaFileWriter
+{
+public:
+    explicit OMTMediaFileWriter(const OMTAsyncWriterOptions& options = OMTAsyncWriterOptions()) : file_(options)
+    {
+        memset(&header_, 0, sizeof(header_));
+    }
+    ~OMTMediaFileWriter() { close(); }
+
+    bool open(const char* path, std::string& error)
+    {
+        close();
+        if (!file_.open(path, error))
+        {
+            return false;
+        }
+        memset(&header_, 0, sizeof(header_));
+        memcpy(header_.magic, OMT_MEDIA_FILE_MAGIC, sizeof(header_.magic));
+        header_.version = OMT_MEDIA_FILE_VERSION;
+        header_.headerSize = sizeof(header_);
+        index_.clear();
+
+        // Placeholder until close() knows the index position
+        if (!file_.write(&header_, sizeof(header_)))
+        {
+            error = "write failed";
+            file_.close();
+            return false;
+        }
+        return true;
+    }
+
+    // Format fields stored in the header; taken from the first video and audio frame written
+    OMTMediaFileHeader& header() { return header_; }
+
+    bool write(uint32_t type, uint32_t codec, int64_t timestamp, uint32_t info, const void* data, uint32_t length)
+    {
+        if (!file_.isOpen() || !file_.pad(OMT_MEDIA_FILE_ALIGNMENT))
+        {
+            return false;
+        }
+        uint64_t offset = file_.position();
+        if (!file_.write(data, length))
+        {
+            return false;
+        }
+        OMTMediaFileEntry entry = {};
+        entry.offset = offset;
+        entry.timestamp = timestamp;
+        entry.length = length;
+        entry.type = type;
+        entry.codec = codec;
+        entry.info = info;
+        index_.push_back(entry);
+        return true;
+    }
+
+    size_t frameCount() const { return index_.size(); }
+    uint64_t bytesWritten() const { return file_.position(); }
+
+    // True if a frame of length bytes can be written without waiting for the disk
+    bool writable(size_t length) { return file_.writable(length + OMT_MEDIA_FILE_ALIGNMENT); }
+
+    // Disk side: bytes that have reached the file and how often write() waited for it
+    OMTAsyncWriterStats stats() { return file_.stats(); }
+
+    // Writes the index and the final header. Returns false if either could not be written.
+    bool close()
+    {
+        if (!file_.isOpen())
+        {
+            return true;
+        }
+        header_.frameCount = (uint32_t)index_.size();
+        header_.indexOffset = file_.position();
+        bool ok = index_.empty() || file_.write(&index_[0], sizeof(OMTMediaFileEntry) * index_.size());
+        ok = ok && file_.writeAt(0, &header_, sizeof(header_));
+        ok = file_.close() && ok;
+        return ok;
+    }
+
+private:
+    OMTMediaFileWriter(const OMTMediaFileWriter&);
+    OMTMediaFileWriter& operator=(const OMTMediaFileWriter&);
+
+    OMTAsyncWriter file_;
+    OMTMediaFileHeader header_;
+    std::vector<OMTMediaFileEntry> index_;
+};
+
+class OMTMediaFileReader
+{
+public:
+    OMTMediaFileReader() : map_(NULL), length_(0), header_(NULL), index_(NULL) {}
+    ~OMTMediaFileReader() { close(); }
+
+    bool open(const char* path, std::string& error)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            error = std::string("cannot open ") + path;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(OMTMediaFileHeader))
+        {
+            error = "file too small";
+            ::close(fd);
+            return false;
+        }
+        void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED)
+        {
+            error = "mmap failed";
+            return false;
+        }
+        map_ = (uint8_t*)map;
+        length_ = (size_t)st.st_size;
+        header_ = (const OMTMediaFileHeader*)map_;
+
+        if (memcmp(header_->magic, OMT_MEDIA_FILE_MAGIC, sizeof(header_->magic)) || header_->version != OMT_MEDIA_FILE_VERSION)
+        {
+            error = "not an OMT media file";
+            close();
+            return false;
+        }
+        uint64_t indexBytes = (uint64_t)header_->frameCount * sizeof(OMTMediaFileEntry);
+        if (header_->indexOffset < sizeof(OMTMediaFileHeader) || header_->indexOffset > length_ || indexBytes > length_ - header_->indexOffset)
+        {
+            error = "index missing or truncated (was the capture interrupted?)";
+            close();
+            return false;
+        }
+        index_ = (const OMTMediaFileEntry*)(map_ + header_->indexOffset);
+        for (uint32_t i = 0; i < header_->frameCount; i++)
+        {
+            if (index_[i].offset > header_->indexOffset || index_[i].length > header_->indexOffset - index_[i].offset)
+            {
+                error = "index entry outside the file";
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (map_)
+        {
+            munmap(map_, length_);
+        }
+        map_ = NULL;
+        length_ = 0;
+        header_ = NULL;
+        index_ = NULL;
+    }
+
+    const OMTMediaFileHeader& header() const { return *header_; }
+    uint32_t frameCount() const { return header_ ? header_->frameCount : 0; }
+    const OMTMediaFileEntry& entry(uint32_t i) const { return index_[i]; }
+    const void* data(uint32_t i) const { return map_ + index_[i].offset; }
+
+    // First entry stamped at or after timestamp, by binary search of the index; frameCount() if none.
+    // Entries are in arrival order, so timestamps from different frame types may interleave
+    // slightly out of order, which moves the result by at most a frame or so.
+    uint32_t find(int64_t timestamp) const
+    {
+        uint32_t low = 0, high = frameCount();
+        while (low < high)
+        {
+            uint32_t middle = low + (high - low) / 2;
+            if (index_[middle].timestamp < timestamp)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    // Asks the OS to read the whole file in now, so replay does not stall on page faults
+    void prefetch() const
+    {
+        if (map_)
+        {
+            madvise(map_, length_, MADV_WILLNEED);
+        }
+    }
+
+private:
+    OMTMediaFileReader(const OMTMediaFileReader&);
+    OMTMediaFileReader& operator=(const OMTMediaFileReader&);
+
+    uint8_t* map_;
+    size_t length_;
+    const OMTMediaFileHeader* header_;
+    const OMTMediaFileEntry* index_;
+};
@@ -0,0 +1,246 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_pixel_convert.h converts 8-bit UYVY frames into the other pixel formats an OMT sender
+	accepts, so a test image can be fed to OMT in each of them.
+
+	Planar outputs use the layouts described in libomt.h: the Y plane with a stride of width,
+	followed by the chroma plane(s). Chroma is averaged over line pairs for 4:2:0. BGRA uses
+	BT.709 limited range coefficients. Width and height must be even.
+
+	P216 and PA16 place each 8-bit sample in the top byte of a 16-bit one, which maps limited
+	range 8-bit video onto limited range 16-bit exactly. Read as 16-bit words, UYVY is already
+	U|Y<<8 and V|Y<<8, so the conversion is a mask for luma and a shift for chroma: AVX2 or SSE2
+	when the compiler targets them, a scalar loop otherwise.  */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OMT_PIXEL_CONVERT_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OMT_PIXEL_CONVERT_SSE2 1
+#endif
+
+// Packed 4:2:2 with the luma first: UYVY -> YUY2
+inline void omtConvertUyvyToYuy2(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* s = src + (size_t)y * srcStride;
+        uint8_t* d = dst + (size_t)y * dstStride;
+        for (int x = 0; x < width * 2; x += 4)
+        {
+            d[x] = s[x + 1];
+            d[x + 1] = s[x];
+            d[x + 2] = s[x + 3];
+            d[x + 3] = s[x + 2];
+        }
+    }
+}
+
+// Y plane followed by an interleaved U/V plane of half height: dst holds width * height * 3 / 2 bytes
+inline void omtConvertUyvyToNv12(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height)
+{
+    uint8_t* chroma = dst + (size_t)width * height;
+    for (int y = 0; y < height; y += 2)
+    {
+        const uint8_t* s0 = src + (size_t)y * srcStride;
+        const uint8_t* s1 = s0 + srcStride;
+        uint8_t* y0 = dst + (size_t)y * width;
+        uint8_t* y1 = y0 + width;
+        uint8_t* uv = chroma + (size_t)(y / 2) * width;
+        for (int x = 0; x < width; x += 2)
+        {
+            const uint8_t* p0 = s0 + x * 2;
+            const uint8_t* p1 = s1 + x * 2;
+            y0[x] = p0[1];
+            y0[x + 1] = p0[3];
+            y1[x] = p1[1];
+            y1[x + 1] = p1[3];
+            uv[x] = (uint8_t)((p0[0] + p1[0] + 1) >> 1);
+            uv[x + 1] = (uint8_t)((p0[2] + p1[2] + 1) >> 1);
+        }
+    }
+}
+
+// Y plane followed by quarter size V and U planes: dst holds width * height * 3 / 2 bytes
+inline void omtConvertUyvyToYv12(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height)
+{
+    size_t lumaSize = (size_t)width * height;
+    uint8_t* vPlane = dst + lumaSize;
+    uint8_t* uPlane = vPlane + lumaSize / 4;
+    for (int y = 0; y < height; y += 2)
+    {
+        const uint8_t* s0 = src + (size_t)y * srcStride;
+        const uint8_t* s1 = s0 + srcStride;
+        uint8_t* y0 = dst + (size_t)y * width;
+        uint8_t* y1 = y0 + width;
+        uint8_t* u = uPlane + (size_t)(y / 2) * (width / 2);
+        uint8_t* v = vPlane + (size_t)(y / 2) * (width / 2);
+        for (int x = 0; x < width; x += 2)
+        {
+            const uint8_t* p0 = s0 + x * 2;
+            const uint8_t* p1 = s1 + x * 2;
+            y0[x] = p0[1];
+            y0[x + 1] = p0[3];
+            y1[x] = p1[1];
+            y1[x + 1] = p1[3];
+            u[x / 2] = (uint8_t)((p0[0] + p1[0] + 1) >> 1);
+            v[x / 2] = (uint8_t)((p0[2] + p1[2] + 1) >> 1);
+        }
+    }
+}
+
+inline uint8_t omtClampByte(int value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// BT.709 limited range YUV to full range BGRA with opaque alpha
+inline void omtConvertUyvyToBgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* s = src + (size_t)y * srcStride;
+        uint8_t* d = dst + (size_t)y * dstStride;
+        for (int x = 0; x < width; x += 2)
+        {
+            int u = s[0] - 128;
+            int v = s[2] - 128;
+            int r = 459 * v;
+            int g = -55 * u - 136 * v;
+            int b = 541 * u;
+            for (int i = 0; i < 2; i++)
+            {
+                int luma = 298 * (s[1 + i * 2] - 16) + 128;
+                d[0] = omtClampByte((luma + b) >> 8);
+                d[1] = omtClampByte((luma + g) >> 8);
+                d[2] = omtClampByte((luma + r) >> 8);
+                d[3] = 255;
+                d += 4;
+            }
+            s += 4;
+        }
+    }
+}
+
+// UYVY followed by an opaque alpha plane of width * height bytes
+inline void omtConvertUyvyToUyva(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        memcpy(dst + (size_t)y * width * 2, src + (size_t)y * srcStride, (size_t)width * 2);
+    }
+    memset(dst + (size_t)width * 2 * height, 255, (size_t)width * height);
+}
+
+// UYVY at half width and height, each output sample the average of a 2x2 block. Width must be a multiple of 4.
+inline void omtScaleUyvyHalf(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    for (int y = 0; y < height / 2; y++)
+    {
+        const uint8_t* s0 = src + (size_t)y * 2 * srcStride;
+        const uint8_t* s1 = s0 + srcStride;
+        uint8_t* d = dst + (size_t)y * dstStride;
+        for (int x = 0; x < width * 2; x += 8)
+        {
+            // Two source macropixels (U Y V Y U Y V Y) per line become one
+            d[0] = (uint8_t)((s0[x] + s0[x + 4] + s1[x] + s1[x + 4] + 2) >> 2);
+            d[1] = (uint8_t)((s0[x + 1] + s0[x + 3] + s1[x + 1] + s1[x + 3] + 2) >> 2);
+            d[2] = (uint8_t)((s0[x + 2] + s0[x + 6] + s1[x + 2] + s1[x + 6] + 2) >> 2);
+            d[3] = (uint8_t)((s0[x + 5] + s0[x + 7] + s1[x + 5] + s1[x + 7] + 2) >> 2);
+            d += 4;
+        }
+    }
+}
+
+// Instruction set the 16-bit conversions were built for
+inline const char* omtPixelConvertSimd()
+{
+#if defined(OMT_PIXEL_CONVERT_AVX2)
+    return "AVX2";
+#elif defined(OMT_PIXEL_CONVERT_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// One line of UYVY into a P216 luma line and interleaved chroma line of width samples each
+inline void omtUyvyLineToP216(const uint8_t* src, uint16_t* y, uint16_t* uv, int width, bool simd = true)
+{
+    int x = 0;
+    if (simd)
+    {
+#if defined(OMT_PIXEL_CONVERT_AVX2)
+        const __m256i lumaMask256 = _mm256_set1_epi16((short)0xFF00);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m256i words = _mm256_loadu_si256((const __m256i*)(src + x * 2));
+            _mm256_storeu_si256((__m256i*)(y + x), _mm256_and_si256(words, lumaMask256));
+            _mm256_storeu_si256((__m256i*)(uv + x), _mm256_slli_epi16(words, 8));
+        }
+#endif
+#if defined(OMT_PIXEL_CONVERT_SSE2)
+        const __m128i lumaMask = _mm_set1_epi16((short)0xFF00);
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i*)(src + x * 2));
+            _mm_storeu_si128((__m128i*)(y + x), _mm_and_si128(words, lumaMask));
+            _mm_storeu_si128((__m128i*)(uv + x), _mm_slli_epi16(words, 8));
+        }
+#endif
+    }
+    for (const uint8_t* s = src + (size_t)x * 2; x < width; x++, s += 2)
+    {
+        y[x] = (uint16_t)(s[1] << 8);
+        uv[x] = (uint16_t)(s[0] << 8);
+    }
+}
+
+// 16-bit Y plane followed by the interleaved 16-bit U/V plane: dst holds width * height * 4 bytes
+inline void omtConvertUyvyToP216(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height, bool simd = true)
+{
+    uint16_t* luma = (uint16_t*)dst;
+    uint16_t* chroma = luma + (size_t)width * height;
+    for (int y = 0; y < height; y++)
+    {
+        omtUyvyLineToP216(src + (size_t)y * srcStride, luma + (size_t)y * width, chroma + (size_t)y * width, width, simd);
+    }
+}
+
+// P216 followed by an opaque 16-bit alpha plane: dst holds width * height * 6 bytes
+inline void omtConvertUyvyToPa16(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height, bool simd = true)
+{
+    omtConvertUyvyToP216(src, srcStride, dst, width, height, simd);
+    memset(dst + (size_t)width * height * 4, 255, (size_t)width * height * 2);
+}
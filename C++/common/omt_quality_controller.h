@@ -0,0 +1,175 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_quality_controller.h picks an encoding step for an OMT sender from its own statistics, so a
+	host that runs out of encoding time lowers quality instead of dropping frames.
+
+	The application describes a ladder of steps, best first: an OMTQuality and a resolution
+	divisor. Once per statistics interval it passes the cumulative video statistics to update().
+	The average encode time per frame over the interval is compared with the frame period:
+
+		above targetLoad, or any frame dropped   -> overloaded
+		below recoverLoad and nothing dropped    -> spare capacity
+
+	overloadIntervals overloaded intervals in a row move one step down the ladder and
+	recoverIntervals intervals with spare capacity move one step up. A step up that has to be
+	undone soon after doubles the wait before the next attempt, so a host near its limit settles
+	rather than oscillating.
+
+	The controller only decides. Quality is fixed when a sender is created, so applying a step
+	means recreating the sender (and rescaling the frames for a new divisor), then calling reset().
+
+	Include libomt.h before this header.  */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct OMTQualityStep
+{
+    OMTQuality quality;
+    int divisor;                // 1 for full resolution, 2 for half width and height
+};
+
+struct OMTQualityControllerOptions
+{
+    double targetLoad = 0.5;        // Encode time budget as a fraction of the frame period
+    double recoverLoad = 0.3;       // Load below which a step up is considered
+    int overloadIntervals = 2;
+    int recoverIntervals = 10;
+    int maxRecoverIntervals = 160;  // Limit for the backoff after failed step ups
+};
+
+class OMTQualityController
+{
+public:
+    OMTQualityController(const OMTQualityControllerOptions& options, const std::vector<OMTQualityStep>& ladder, int frameRateN, int frameRateD)
+        : options_(options), ladder_(ladder), step_(0), framePeriodMs_(1000.0 * frameRateD / frameRateN),
+          recoverIntervals_(options.recoverIntervals), load_(0)
+    {
+        if (ladder_.empty())
+        {
+            OMTQualityStep step = { OMTQuality_Default, 1 };
+            ladder_.push_back(step);
+        }
+        reset();
+    }
+
+    // Call after the sender has been recreated: its statistics start again from zero and the
+    // first interval includes encoder start up, so it is not judged.
+    void reset()
+    {
+        haveBaseline_ = false;
+        overloaded_ = 0;
+        spare_ = 0;
+    }
+
+    // Feeds one interval of statistics. Returns true when the step changed.
+    bool update(const OMTStatistics& video)
+    {
+        if (!haveBaseline_ || video.Frames < last_.Frames)
+        {
+            last_ = video;
+            haveBaseline_ = true;
+            return false;
+        }
+        int64_t frames = video.Frames - last_.Frames;
+        int64_t dropped = video.FramesDropped - last_.FramesDropped;
+        int64_t codecTime = video.CodecTime - last_.CodecTime;
+        if (frames <= 0 && dropped <= 0)
+        {
+            // No new statistics since the last call
+            return false;
+        }
+        last_ = video;
+
+        double encodeMs = frames > 0 ? (double)codecTime / frames : (double)video.CodecTimeSinceLast;
+        load_ = encodeMs / framePeriodMs_;
+
+        if (load_ > options_.targetLoad || dropped > 0)
+        {
+            spare_ = 0;
+            if (++overloaded_ >= options_.overloadIntervals && step_ + 1 < (int)ladder_.size())
+            {
+                if (recentStepUp_)
+                {
+                    recoverIntervals_ = recoverIntervals_ * 2 < options_.maxRecoverIntervals ? recoverIntervals_ * 2 : options_.maxRecoverIntervals;
+                }
+                return change(step_ + 1, false);
+            }
+        }
+        else if (load_ < options_.recoverLoad)
+        {
+            overloaded_ = 0;
+            if (++spare_ >= recoverIntervals_ && step_ > 0)
+            {
+                return change(step_ - 1, true);
+            }
+        }
+        else
+        {
+            overloaded_ = 0;
+            spare_ = 0;
+        }
+
+        // Once a step up has held for as long as it took to earn it, it no longer counts as recent
+        if (recentStepUp_ && ++intervalsSinceChange_ >= recoverIntervals_)
+        {
+            recentStepUp_ = false;
+            recoverIntervals_ = options_.recoverIntervals;
+        }
+        return false;
+    }
+
+    int stepIndex() const { return step_; }
+    const OMTQualityStep& step() const { return ladder_[step_]; }
+
+    // Encode time over the last interval as a fraction of the frame period
+    double load() const { return load_; }
+
+private:
+    bool change(int step, bool up)
+    {
+        step_ = step;
+        recentStepUp_ = up;
+        intervalsSinceChange_ = 0;
+        reset();
+        return true;
+    }
+
+    OMTQualityControllerOptions options_;
+    std::vector<OMTQualityStep> ladder_;
+    int step_;
+    double framePeriodMs_;
+    int recoverIntervals_;
+    double load_;
+    bool haveBaseline_ = false;
+    OMTStatistics last_ = {};
+    int overloaded_ = 0;
+    int spare_ = 0;
+    bool recentStepUp_ = false;
+    int intervalsSinceChange_ = 0;
+};
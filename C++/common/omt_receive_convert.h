@@ -0,0 +1,824 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_receive_convert.h converts the uncompressed frames an OMT receiver delivers (UYVY, UYVA,
+	P216 and PA16, and BGRA/BGRX for the RGB outputs) into the formats downstream consumers want:
+
+		NV12    Y plane, then interleaved U/V at half height             width * height * 3 / 2 bytes
+		I420    Y plane, then U and V planes at half width and height    width * height * 3 / 2 bytes
+		BGRA    8-bit, alpha from UYVA/PA16/BGRA or opaque               width * 4 bytes per row
+		v210    10-bit 4:2:2, 6 pixels in 16 bytes                       rows padded to 128 bytes
+		RGBP    planar R, G and B, 8-bit                                 width * height * 3 bytes
+
+	Each conversion is a per line kernel, with AVX2, SSSE3 or SSE2 versions where the compiler
+	targets them and a scalar version that is the reference: the SIMD kernels produce the same
+	bytes. 16-bit sources are reduced to 8 bits (or 10 for v210) by truncation, a line at a time,
+	before the 8-bit kernels run. YUV to RGB uses the BT.709 limited range coefficients of
+	omt_pixel_convert.h. Chroma for 4:2:0 is the rounded average of each line pair.
+
+	omtConvertFrame splits the frame into bands of rows and, given an OMTConvertWorkers, converts
+	the bands on several threads at once, which is what keeps up with UHD.
+
+	Include libomt.h before this header.  */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OMT_RECEIVE_CONVERT_AVX2 1
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define OMT_RECEIVE_CONVERT_SSSE3 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OMT_RECEIVE_CONVERT_SSE2 1
+#endif
+
+enum OMTConvertFormat
+{
+    OMTConvertFormat_NV12,
+    OMTConvertFormat_I420,
+    OMTConvertFormat_BGRA,
+    OMTConvertFormat_V210,
+    OMTConvertFormat_RGBP,
+    OMTConvertFormat_Count
+};
+
+inline const char* omtConvertFormatName(OMTConvertFormat format)
+{
+    static const char* names[] = { "nv12", "i420", "bgra", "v210", "rgbp" };
+    return format < OMTConvertFormat_Count ? names[format] : "unknown";
+}
+
+inline bool omtConvertFormatParse(const char* name, OMTConvertFormat& format)
+{
+    for (int f = 0; f < OMTConvertFormat_Count; f++)
+    {
+        const char* candidate = omtConvertFormatName((OMTConvertFormat)f);
+        size_t i = 0;
+        while (candidate[i] && name[i] && (name[i] | 0x20) == candidate[i])
+        {
+            i++;
+        }
+        if (!candidate[i] && !name[i])
+        {
+            format = (OMTConvertFormat)f;
+            return true;
+        }
+    }
+    return false;
+}
+
+// FourCC of the output, as used for OMTCodec values. I420, v210 and RGBP have no OMTCodec.
+inline uint32_t omtConvertFormatFourCC(OMTConvertFormat format)
+{
+    switch (format)
+    {
+    case OMTConvertFormat_NV12: return OMTCodec_NV12;
+    case OMTConvertFormat_I420: return 0x30323449;   // 'I420'
+    case OMTConvertFormat_BGRA: return OMTCodec_BGRA;
+    case OMTConvertFormat_V210: return 0x30313276;   // 'v210'
+    default: return 0x50424752;                      // 'RGBP'
+    }
+}
+
+// Bytes per row of the first (or only) plane
+inline int omtConvertStride(OMTConvertFormat format, int width)
+{
+    switch (format)
+    {
+    case OMTConvertFormat_BGRA: return width * 4;
+    case OMTConvertFormat_V210: return (width + 47) / 48 * 128;
+    default: return width;
+    }
+}
+
+inline size_t omtConvertSize(OMTConvertFormat format, int width, int height)
+{
+    switch (format)
+    {
+    case OMTConvertFormat_NV12:
+    case OMTConvertFormat_I420: return (size_t)width * height * 3 / 2;
+    case OMTConvertFormat_RGBP: return (size_t)width * height * 3;
+    default: return (size_t)omtConvertStride(format, width) * height;
+    }
+}
+
+inline bool omtConvertSupported(uint32_t codec, OMTConvertFormat format)
+{
+    switch (codec)
+    {
+    case OMTCodec_UYVY:
+    case OMTCodec_UYVA:
+    case OMTCodec_P216:
+    case OMTCodec_PA16:
+        return format < OMTConvertFormat_Count;
+    case OMTCodec_BGRA:
+        return format == OMTConvertFormat_BGRA || format == OMTConvertFormat_RGBP;
+    default:
+        return false;
+    }
+}
+
+// Instruction sets the line kernels were built with
+inline const char* omtReceiveConvertSimd()
+{
+#if defined(OMT_RECEIVE_CONVERT_AVX2)
+    return "AVX2";
+#elif defined(OMT_RECEIVE_CONVERT_SSSE3)
+    return "SSSE3";
+#elif defined(OMT_RECEIVE_CONVERT_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// ---- line kernels. width is in pixels and even; x counts pixels. ----
+
+// P216 luma and interleaved chroma lines to an 8-bit UYVY line, keeping the top byte
+inline void omtLineP216ToUyvy(const uint16_t* y, const uint16_t* uv, uint8_t* dst, int width, bool simd)
+{
+    int x = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+    if (simd)
+    {
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i luma = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(y + x)), 8);
+            __m128i chroma = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(uv + x)), 8);
+            // chroma in the low byte of each word and luma in the high one: U Y V Y ...
+            _mm_storeu_si128((__m128i*)(dst + x * 2), _mm_or_si128(chroma, _mm_slli_epi16(luma, 8)));
+        }
+    }
+#endif
+    (void)simd;
+    for (; x < width; x++)
+    {
+        dst[x * 2] = (uint8_t)(uv[x] >> 8);
+        dst[x * 2 + 1] = (uint8_t)(y[x] >> 8);
+    }
+}
+
+// Top byte of each 16-bit alpha sample
+inline void omtLineAlpha16To8(const uint16_t* alpha, uint8_t* dst, int width, bool simd)
+{
+    int x = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+    if (simd)
+    {
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i a = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(alpha + x)), 8);
+            __m128i b = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(alpha + x + 8)), 8);
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(a, b));
+        }
+    }
+#endif
+    (void)simd;
+    for (; x < width; x++)
+    {
+        dst[x] = (uint8_t)(alpha[x] >> 8);
+    }
+}
+
+// Two UYVY lines to two NV12 luma lines and one interleaved chroma line
+inline void omtLineUyvyToNv12(const uint8_t* s0, const uint8_t* s1, uint8_t* y0, uint8_t* y1, uint8_t* uv, int width, bool simd)
+{
+    int x = 0;
+    if (simd)
+    {
+#if defined(OMT_RECEIVE_CONVERT_AVX2)
+        const __m256i low256 = _mm256_set1_epi16(0x00FF);
+        for (; x + 32 <= width; x += 32)
+        {
+            __m256i a0 = _mm256_loadu_si256((const __m256i*)(s0 + x * 2));
+            __m256i a1 = _mm256_loadu_si256((const __m256i*)(s0 + x * 2 + 32));
+            __m256i b0 = _mm256_loadu_si256((const __m256i*)(s1 + x * 2));
+            __m256i b1 = _mm256_loadu_si256((const __m256i*)(s1 + x * 2 + 32));
+            // packus works within 128-bit lanes; the permute puts the 64-bit quarters back in order
+            _mm256_storeu_si256((__m256i*)(y0 + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8)), 0xD8));
+            _mm256_storeu_si256((__m256i*)(y1 + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8)), 0xD8));
+            __m256i c0 = _mm256_and_si256(_mm256_avg_epu8(a0, b0), low256);
+            __m256i c1 = _mm256_and_si256(_mm256_avg_epu8(a1, b1), low256);
+            _mm256_storeu_si256((__m256i*)(uv + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(c0, c1), 0xD8));
+        }
+#endif
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+        const __m128i low = _mm_set1_epi16(0x00FF);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i a0 = _mm_loadu_si128((const __m128i*)(s0 + x * 2));
+            __m128i a1 = _mm_loadu_si128((const __m128i*)(s0 + x * 2 + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*)(s1 + x * 2));
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(s1 + x * 2 + 16));
+            _mm_storeu_si128((__m128i*)(y0 + x), _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8)));
+            _mm_storeu_si128((__m128i*)(y1 + x), _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8)));
+            __m128i c0 = _mm_and_si128(_mm_avg_epu8(a0, b0), low);
+            __m128i c1 = _mm_and_si128(_mm_avg_epu8(a1, b1), low);
+            _mm_storeu_si128((__m128i*)(uv + x), _mm_packus_epi16(c0, c1));
+        }
+#endif
+    }
+    for (; x < width; x += 2)
+    {
+        const uint8_t* p0 = s0 + x * 2;
+        const uint8_t* p1 = s1 + x * 2;
+        y0[x] = p0[1];
+        y0[x + 1] = p0[3];
+        y1[x] = p1[1];
+        y1[x + 1] = p1[3];
+        uv[x] = (uint8_t)((p0[0] + p1[0] + 1) >> 1);
+        uv[x + 1] = (uint8_t)((p0[2] + p1[2] + 1) >> 1);
+    }
+}
+
+// Two UYVY lines to two I420 luma lines and one line each of U and V
+inline void omtLineUyvyToI420(const uint8_t* s0, const uint8_t* s1, uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width, bool simd)
+{
+    int x = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+    if (simd)
+    {
+        const __m128i low = _mm_set1_epi16(0x00FF);
+        for (; x + 32 <= width; x += 32)
+        {
+            __m128i a[4], b[4], c[4];
+            for (int i = 0; i < 4; i++)
+            {
+                a[i] = _mm_loadu_si128((const __m128i*)(s0 + x * 2 + i * 16));
+                b[i] = _mm_loadu_si128((const __m128i*)(s1 + x * 2 + i * 16));
+                c[i] = _mm_and_si128(_mm_avg_epu8(a[i], b[i]), low);
+            }
+            for (int i = 0; i < 4; i += 2)
+            {
+                _mm_storeu_si128((__m128i*)(y0 + x + i * 8), _mm_packus_epi16(_mm_srli_epi16(a[i], 8), _mm_srli_epi16(a[i + 1], 8)));
+                _mm_storeu_si128((__m128i*)(y1 + x + i * 8), _mm_packus_epi16(_mm_srli_epi16(b[i], 8), _mm_srli_epi16(b[i + 1], 8)));
+            }
+            // U V U V ... for 32 pixels, then split the pairs
+            __m128i uv0 = _mm_packus_epi16(c[0], c[1]);
+            __m128i uv1 = _mm_packus_epi16(c[2], c[3]);
+            _mm_storeu_si128((__m128i*)(u + x / 2), _mm_packus_epi16(_mm_and_si128(uv0, low), _mm_and_si128(uv1, low)));
+            _mm_storeu_si128((__m128i*)(v + x / 2), _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8)));
+        }
+    }
+#endif
+    (void)simd;
+    for (; x < width; x += 2)
+    {
+        const uint8_t* p0 = s0 + x * 2;
+        const uint8_t* p1 = s1 + x * 2;
+        y0[x] = p0[1];
+        y0[x + 1] = p0[3];
+        y1[x] = p1[1];
+        y1[x + 1] = p1[3];
+        u[x / 2] = (uint8_t)((p0[0] + p1[0] + 1) >> 1);
+        v[x / 2] = (uint8_t)((p0[2] + p1[2] + 1) >> 1);
+    }
+}
+
+inline uint8_t omtConvertClamp(int value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// One macropixel to two RGB pixels with the coefficients of omtConvertUyvyToBgra
+inline void omtMacropixelToRgb(const uint8_t* s, uint8_t rgb[2][3])
+{
+    int u = s[0] - 128;
+    int v = s[2] - 128;
+    int r = 459 * v;
+    int g = -55 * u - 136 * v;
+    int b = 541 * u;
+    for (int i = 0; i < 2; i++)
+    {
+        int luma = 298 * (s[1 + i * 2] - 16) + 128;
+        rgb[i][0] = omtConvertClamp((luma + r) >> 8);
+        rgb[i][1] = omtConvertClamp((luma + g) >> 8);
+        rgb[i][2] = omtConvertClamp((luma + b) >> 8);
+    }
+}
+
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+// Four pixels from UYVY widened to 16-bit words (U Y V Y U Y V Y): B, G and R as 32-bit lanes.
+// madd pairs each sample with a coefficient and its neighbour with another, so the arithmetic is
+// exactly that of the scalar kernel.
+inline void omtRgbFromWords(__m128i words, __m128i& b, __m128i& g, __m128i& r)
+{
+    words = _mm_sub_epi16(words, _mm_setr_epi16(128, 16, 128, 16, 128, 16, 128, 16));
+    __m128i luma = _mm_add_epi32(_mm_madd_epi16(words, _mm_setr_epi16(0, 298, 0, 298, 0, 298, 0, 298)), _mm_set1_epi32(128));
+    __m128i uv = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, _MM_SHUFFLE(2, 0, 2, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm_srai_epi32(_mm_add_epi32(luma, _mm_madd_epi16(uv, _mm_setr_epi16(541, 0, 541, 0, 541, 0, 541, 0))), 8);
+    g = _mm_srai_epi32(_mm_add_epi32(luma, _mm_madd_epi16(uv, _mm_setr_epi16(-55, -136, -55, -136, -55, -136, -55, -136))), 8);
+    r = _mm_srai_epi32(_mm_add_epi32(luma, _mm_madd_epi16(uv, _mm_setr_epi16(0, 459, 0, 459, 0, 459, 0, 459))), 8);
+}
+
+// B, G, R lanes and four alpha words to 16 bytes of BGRA; the saturating packs do the clamping
+inline __m128i omtBgraFromRgb(__m128i b, __m128i g, __m128i r, __m128i alpha)
+{
+    __m128i bg = _mm_packs_epi32(b, g);
+    __m128i ra = _mm_unpacklo_epi64(_mm_packs_epi32(r, r), alpha);
+    __m128i br = _mm_unpacklo_epi16(bg, ra);
+    __m128i ga = _mm_unpackhi_epi16(bg, ra);
+    return _mm_packus_epi16(_mm_unpacklo_epi16(br, ga), _mm_unpackhi_epi16(br, ga));
+}
+#endif
+
+#if defined(OMT_RECEIVE_CONVERT_AVX2)
+// The same on two groups of four pixels at once, one per 128-bit lane
+inline void omtRgbFromWords256(__m256i words, __m256i& b, __m256i& g, __m256i& r)
+{
+    words = _mm256_sub_epi16(words, _mm256_setr_epi16(128, 16, 128, 16, 128, 16, 128, 16, 128, 16, 128, 16, 128, 16, 128, 16));
+    __m256i luma = _mm256_add_epi32(_mm256_madd_epi16(words, _mm256_set1_epi32(298 << 16)), _mm256_set1_epi32(128));
+    __m256i uv = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(words, _MM_SHUFFLE(2, 0, 2, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm256_srai_epi32(_mm256_add_epi32(luma, _mm256_madd_epi16(uv, _mm256_set1_epi32(541))), 8);
+    g = _mm256_srai_epi32(_mm256_add_epi32(luma, _mm256_madd_epi16(uv, _mm256_set1_epi32((int)(((uint32_t)(uint16_t)-136 << 16) | (uint16_t)-55)))), 8);
+    r = _mm256_srai_epi32(_mm256_add_epi32(luma, _mm256_madd_epi16(uv, _mm256_set1_epi32(459 << 16))), 8);
+}
+
+inline __m256i omtBgraFromRgb256(__m256i b, __m256i g, __m256i r, __m256i alpha)
+{
+    __m256i bg = _mm256_packs_epi32(b, g);
+    __m256i ra = _mm256_unpacklo_epi64(_mm256_packs_epi32(r, r), alpha);
+    __m256i br = _mm256_unpacklo_epi16(bg, ra);
+    __m256i ga = _mm256_unpackhi_epi16(bg, ra);
+    return _mm256_packus_epi16(_mm256_unpacklo_epi16(br, ga), _mm256_unpackhi_epi16(br, ga));
+}
+#endif
+
+// One UYVY line to BGRA, with alpha from an 8-bit line or opaque when alpha is null
+inline void omtLineUyvyToBgra(const uint8_t* src, const uint8_t* alpha, uint8_t* dst, int width, bool simd)
+{
+    int x = 0;
+    if (simd)
+    {
+#if defined(OMT_RECEIVE_CONVERT_AVX2)
+        for (; x + 8 <= width; x += 8)
+        {
+            // The low lane takes pixels 0-3 and the high lane 4-7
+            __m256i words = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + x * 2)));
+            __m256i alpha16 = _mm256_set1_epi16(255);
+            if (alpha)
+            {
+                // a0-3 into the low four words of the low lane and a4-7 into those of the high lane
+                __m128i a = _mm_loadl_epi64((const __m128i*)(alpha + x));
+                alpha16 = _mm256_cvtepu8_epi16(_mm_shuffle_epi32(a, _MM_SHUFFLE(1, 1, 0, 0)));
+            }
+            __m256i b, g, r;
+            omtRgbFromWords256(words, b, g, r);
+            _mm256_storeu_si256((__m256i*)(dst + x * 4), omtBgraFromRgb256(b, g, r, alpha16));
+        }
+#endif
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + x * 2)), zero);
+            __m128i alpha16 = _mm_set1_epi16(255);
+            if (alpha)
+            {
+                int32_t a;
+                memcpy(&a, alpha + x, 4);
+                alpha16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(a), zero);
+            }
+            __m128i b, g, r;
+            omtRgbFromWords(words, b, g, r);
+            _mm_storeu_si128((__m128i*)(dst + x * 4), omtBgraFromRgb(b, g, r, alpha16));
+        }
+#endif
+    }
+    for (; x < width; x += 2)
+    {
+        uint8_t rgb[2][3];
+        omtMacropixelToRgb(src + x * 2, rgb);
+        for (int i = 0; i < 2; i++)
+        {
+            uint8_t* d = dst + (x + i) * 4;
+            d[0] = rgb[i][2];
+            d[1] = rgb[i][1];
+            d[2] = rgb[i][0];
+            d[3] = alpha ? alpha[x + i] : 255;
+        }
+    }
+}
+
+// One UYVY line to one line each of the R, G and B planes
+inline void omtLineUyvyToRgbp(const uint8_t* src, uint8_t* r, uint8_t* g, uint8_t* b, int width, bool simd)
+{
+    int x = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+    if (simd)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + x * 2)), zero);
+            __m128i bl, gl, rl;
+            omtRgbFromWords(words, bl, gl, rl);
+            // b0-3 g0-3 r0-3 r0-3
+            __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(bl, gl), _mm_packs_epi32(rl, rl));
+            int32_t value = _mm_cvtsi128_si32(bytes);
+            memcpy(b + x, &value, 4);
+            value = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 4));
+            memcpy(g + x, &value, 4);
+            value = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+            memcpy(r + x, &value, 4);
+        }
+    }
+#endif
+    (void)simd;
+    for (; x < width; x += 2)
+    {
+        uint8_t rgb[2][3];
+        omtMacropixelToRgb(src + x * 2, rgb);
+        for (int i = 0; i < 2; i++)
+        {
+            r[x + i] = rgb[i][0];
+            g[x + i] = rgb[i][1];
+            b[x + i] = rgb[i][2];
+        }
+    }
+}
+
+// 10-bit components in v210 order (U Y V Y ...) from an 8-bit UYVY line: width * 2 of them
+inline void omtLineUyvyTo10(const uint8_t* src, uint16_t* dst, int width, bool simd)
+{
+    int i = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+    if (simd)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= width * 2; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_slli_epi16(_mm_unpacklo_epi8(bytes, zero), 2));
+            _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_slli_epi16(_mm_unpackhi_epi8(bytes, zero), 2));
+        }
+    }
+#endif
+    (void)simd;
+    for (; i < width * 2; i++)
+    {
+        dst[i] = (uint16_t)(src[i] << 2);
+    }
+}
+
+// The same from P216 luma and interleaved chroma lines
+inline void omtLineP216To10(const uint16_t* y, const uint16_t* uv, uint16_t* dst, int width, bool simd)
+{
+    int x = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSE2)
+    if (simd)
+    {
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i luma = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(y + x)), 6);
+            __m128i chroma = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(uv + x)), 6);
+            _mm_storeu_si128((__m128i*)(dst + x * 2), _mm_unpacklo_epi16(chroma, luma));
+            _mm_storeu_si128((__m128i*)(dst + x * 2 + 8), _mm_unpackhi_epi16(chroma, luma));
+        }
+    }
+#endif
+    (void)simd;
+    for (; x < width; x++)
+    {
+        dst[x * 2] = (uint16_t)(uv[x] >> 6);
+        dst[x * 2 + 1] = (uint16_t)(y[x] >> 6);
+    }
+}
+
+// Packs 10-bit components into v210: every three go into one little endian 32-bit word, twelve
+// (six pixels) into 16 bytes. components must hold a whole number of groups of 12, zero padded.
+// The row is zero filled out to stride.
+inline void omtLinePackV210(const uint16_t* components, uint8_t* dst, int width, int stride, bool simd)
+{
+    int blocks = (width + 5) / 6;
+    int block = 0;
+#if defined(OMT_RECEIVE_CONVERT_SSSE3)
+    if (simd)
+    {
+        // Lanes of A hold the first two components of each word and lanes of B the third
+        const __m128i maskALow = _mm_setr_epi8(0, 1, 2, 3, 6, 7, 8, 9, 12, 13, 14, 15, -1, -1, -1, -1);
+        const __m128i maskAHigh = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 4, 5);
+        const __m128i maskBLow = _mm_setr_epi8(4, 5, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i maskBHigh = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, -1, -1, 6, 7, -1, -1);
+        const __m128i weights = _mm_set1_epi32((1024 << 16) | 1);
+        for (; block < blocks; block++)
+        {
+            __m128i low = _mm_loadu_si128((const __m128i*)(components + block * 12));
+            __m128i high = _mm_loadl_epi64((const __m128i*)(components + block * 12 + 8));
+            __m128i a = _mm_or_si128(_mm_shuffle_epi8(low, maskALow), _mm_shuffle_epi8(high, maskAHigh));
+            __m128i b = _mm_or_si128(_mm_shuffle_epi8(low, maskBLow), _mm_shuffle_epi8(high, maskBHigh));
+            _mm_storeu_si128((__m128i*)(dst + block * 16), _mm_add_epi32(_mm_madd_epi16(a, weights), _mm_slli_epi32(b, 20)));
+        }
+    }
+#endif
+    (void)simd;
+    for (; block < blocks; block++)
+    {
+        const uint16_t* c = components + block * 12;
+        for (int w = 0; w < 4; w++)
+        {
+            uint32_t word = (uint32_t)c[w * 3] | ((uint32_t)c[w * 3 + 1] << 10) | ((uint32_t)c[w * 3 + 2] << 20);
+            uint8_t* d = dst + block * 16 + w * 4;
+            d[0] = (uint8_t)word;
+            d[1] = (uint8_t)(word >> 8);
+            d[2] = (uint8_t)(word >> 16);
+            d[3] = (uint8_t)(word >> 24);
+        }
+    }
+    if (blocks * 16 < stride)
+    {
+        memset(dst + blocks * 16, 0, (size_t)(stride - blocks * 16));
+    }
+}
+
+// ---- frames ----
+
+// Converts rows [firstRow, endRow) of frame into dst, laid out for the whole frame. Both rows must
+// be even for NV12 and I420. Returns false for unsupported combinations.
+inline bool omtConvertRows(const OMTMediaFrame* frame, OMTConvertFormat format, uint8_t* dst, int firstRow, int endRow, bool simd = true)
+{
+    const int width = frame->Width;
+    const int height = frame->Height;
+    const int stride = frame->Stride;
+    const uint32_t codec = frame->Codec;
+    const uint8_t* data = (const uint8_t*)frame->Data;
+    if (!data || !omtConvertSupported(codec, format) || (width & 1))
+    {
+        return false;
+    }
+    const bool sixteenBit = codec == OMTCodec_P216 || codec == OMTCodec_PA16;
+
+    // Lines of 16-bit sources are reduced to 8-bit UYVY here first; a few spare bytes let the
+    // SIMD kernels read whole vectors past the end of the line
+    std::vector<uint8_t> scratch(sixteenBit ? (size_t)width * 4 + 64 : 0);
+    std::vector<uint8_t> alphaScratch(codec == OMTCodec_PA16 ? (size_t)width + 64 : 0);
+    auto uyvyLine = [&](int y, int which) -> const uint8_t*
+    {
+        if (!sixteenBit)
+        {
+            return data + (size_t)y * stride;
+        }
+        uint8_t* line = &scratch[(size_t)which * width * 2];
+        omtLineP216ToUyvy((const uint16_t*)(data + (size_t)y * stride), (const uint16_t*)(data + (size_t)stride * height + (size_t)y * stride), line, width, simd);
+        return line;
+    };
+    auto alphaLine = [&](int y) -> const uint8_t*
+    {
+        if (!(frame->Flags & OMTVideoFlags_Alpha))
+        {
+            return NULL;
+        }
+        if (codec == OMTCodec_UYVA)
+        {
+            return data + (size_t)stride * height + (size_t)y * width;
+        }
+        if (codec == OMTCodec_PA16)
+        {
+            omtLineAlpha16To8((const uint16_t*)(data + (size_t)stride * height * 2 + (size_t)y * stride), &alphaScratch[0], width, simd);
+            return &alphaScratch[0];
+        }
+        return NULL;
+    };
+
+    switch (format)
+    {
+    case OMTConvertFormat_NV12:
+    case OMTConvertFormat_I420:
+    {
+        uint8_t* chroma = dst + (size_t)width * height;
+        for (int y = firstRow; y + 1 < endRow; y += 2)
+        {
+            const uint8_t* s0 = uyvyLine(y, 0);
+            const uint8_t* s1 = uyvyLine(y + 1, 1);
+            uint8_t* y0 = dst + (size_t)y * width;
+            if (format == OMTConvertFormat_NV12)
+            {
+                omtLineUyvyToNv12(s0, s1, y0, y0 + width, chroma + (size_t)(y / 2) * width, width, simd);
+            }
+            else
+            {
+                uint8_t* u = chroma + (size_t)(y / 2) * (width / 2);
+                uint8_t* v = chroma + (size_t)width * height / 4 + (size_t)(y / 2) * (width / 2);
+                omtLineUyvyToI420(s0, s1, y0, y0 + width, u, v, width, simd);
+            }
+        }
+        return true;
+    }
+    case OMTConvertFormat_BGRA:
+        for (int y = firstRow; y < endRow; y++)
+        {
+            uint8_t* d = dst + (size_t)y * width * 4;
+            if (codec == OMTCodec_BGRA)
+            {
+                memcpy(d, data + (size_t)y * stride, (size_t)width * 4);
+                if (!(frame->Flags & OMTVideoFlags_Alpha))
+                {
+                    // BGRX: the fourth byte is undefined
+                    for (int x = 0; x < width; x++)
+                    {
+                        d[x * 4 + 3] = 255;
+                    }
+                }
+                continue;
+            }
+            omtLineUyvyToBgra(uyvyLine(y, 0), alphaLine(y), d, width, simd);
+        }
+        return true;
+    case OMTConvertFormat_RGBP:
+    {
+        size_t plane = (size_t)width * height;
+        for (int y = firstRow; y < endRow; y++)
+        {
+            uint8_t* r = dst + (size_t)y * width;
+            if (codec == OMTCodec_BGRA)
+            {
+                const uint8_t* s = data + (size_t)y * stride;
+                for (int x = 0; x < width; x++, s += 4)
+                {
+                    r[x] = s[2];
+                    r[plane + x] = s[1];
+                    r[plane * 2 + x] = s[0];
+                }
+                continue;
+            }
+            omtLineUyvyToRgbp(uyvyLine(y, 0), r, r + plane, r + plane * 2, width, simd);
+        }
+        return true;
+    }
+    case OMTConvertFormat_V210:
+    {
+        int outStride = omtConvertStride(format, width);
+        std::vector<uint16_t> components((size_t)(width + 5) / 6 * 12 + 16, 0);
+        for (int y = firstRow; y < endRow; y++)
+        {
+            if (sixteenBit)
+            {
+                omtLineP216To10((const uint16_t*)(data + (size_t)y * stride), (const uint16_t*)(data + (size_t)stride * height + (size_t)y * stride), &components[0], width, simd);
+            }
+            else
+            {
+                omtLineUyvyTo10(data + (size_t)y * stride, &components[0], width, simd);
+            }
+            omtLinePackV210(&components[0], dst + (size_t)y * outStride, width, outStride, simd);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// A fixed set of threads that run the bands of one conversion at a time, the calling thread
+// taking the first band itself
+class OMTConvertWorkers
+{
+public:
+    // threads counts the caller; 0 uses one per hardware thread
+    explicit OMTConvertWorkers(int threads = 0) : job_(NULL), generation_(0), pending_(0), stopping_(false)
+    {
+        if (threads <= 0)
+        {
+            threads = (int)std::thread::hardware_concurrency();
+        }
+        for (int i = 1; i < threads; i++)
+        {
+            threads_.push_back(std::thread(&OMTConvertWorkers::workerLoop, this, i));
+        }
+    }
+
+    ~OMTConvertWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (size_t i = 0; i < threads_.size(); i++)
+        {
+            threads_[i].join();
+        }
+    }
+
+    int threads() const { return (int)threads_.size() + 1; }
+
+    // Calls job(band, bands) once for every band, in parallel, and returns when all are done
+    void run(const std::function<void(int, int)>& job)
+    {
+        if (threads_.empty())
+        {
+            job(0, 1);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            pending_ = (int)threads_.size();
+            generation_++;
+        }
+        start_.notify_all();
+        job(0, threads());
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (pending_ > 0)
+        {
+            done_.wait(lock);
+        }
+        job_ = NULL;
+    }
+
+private:
+    OMTConvertWorkers(const OMTConvertWorkers&);
+    OMTConvertWorkers& operator=(const OMTConvertWorkers&);
+
+    void workerLoop(int band)
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            while (generation_ == seen && !stopping_)
+            {
+                start_.wait(lock);
+            }
+            if (stopping_)
+            {
+                return;
+            }
+            seen = generation_;
+            const std::function<void(int, int)>* job = job_;
+            lock.unlock();
+            (*job)(band, threads());
+            lock.lock();
+            if (--pending_ == 0)
+            {
+                done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void(int, int)>* job_;
+    uint64_t generation_;
+    int pending_;
+    bool stopping_;
+};
+
+// Converts a whole frame into dst, which must hold omtConvertSize bytes. With workers the frame is
+// split into one band of rows per thread.
+inline bool omtConvertFrame(const OMTMediaFrame* frame, OMTConvertFormat format, uint8_t* dst, OMTConvertWorkers* workers = NULL, bool simd = true)
+{
+    if (!frame->Data || !omtConvertSupported(frame->Codec, format) || (frame->Width & 1) || (frame->Height & 1))
+    {
+        return false;
+    }
+    if (!workers || workers->threads() == 1)
+    {
+        return omtConvertRows(frame, format, dst, 0, frame->Height, simd);
+    }
+    // Bands start on even rows so 4:2:0 line pairs are never split
+    int height = frame->Height;
+    workers->run([&](int band, int bands)
+    {
+        int first = (int)((int64_t)height * band / bands) & ~1;
+        int end = band + 1 == bands ? height : (int)((int64_t)height * (band + 1) / bands) & ~1;
+        omtConvertRows(frame, format, dst, first, end, simd);
+    });
+    return true;
+}
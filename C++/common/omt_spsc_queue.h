@@ -0,0 +1,126 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_spsc_queue.h is a bounded lock-free queue of pointers between one producer thread and one
+	consumer thread, for handing frames from a receive thread to a send thread without either
+	waiting on the other.
+
+	Besides push, the producer may evict the oldest queued item, which is what a live relay wants
+	when it falls behind: the freshest frames go out and stale ones are recycled. The consumer's
+	pop and the producer's evict both claim the head with a compare and swap, so each item is taken
+	exactly once.
+
+	Neither side blocks; a consumer that finds the queue empty decides for itself how to wait.  */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+template <typename T>
+class OMTSpscQueue
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit OMTSpscQueue(size_t capacity) : head_(0), tail_(0)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+        mask_ = rounded - 1;
+        slots_.reset(new std::atomic<T*>[rounded]);
+        for (size_t i = 0; i < rounded; i++)
+        {
+            slots_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Producer only. False if the queue is full.
+    bool push(T* item)
+    {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_)
+        {
+            return false;
+        }
+        slots_[tail & mask_].store(item, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Null if the queue is empty.
+    T* pop() { return take(); }
+
+    // Producer only: removes and returns the oldest item, or null if the consumer got there first
+    T* evict() { return take(); }
+
+    // A snapshot; exact only when called from one of the two threads with the other idle
+    size_t size() const
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? (size_t)(tail - head) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    OMTSpscQueue(const OMTSpscQueue&);
+    OMTSpscQueue& operator=(const OMTSpscQueue&);
+
+    T* take()
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            // The slot cannot be reused until head moves past it, so a value read before a
+            // successful exchange is the one that was pushed there
+            T* item = slots_[head & mask_].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return item;
+            }
+        }
+    }
+
+    // Head and tail 64 bytes apart so the two threads do not share a cache line. Padding rather
+    // than alignas keeps the queue usable with plain new before C++17.
+    std::atomic<uint64_t> head_;
+    char headPadding_[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail_;
+    char tailPadding_[64 - sizeof(std::atomic<uint64_t>)];
+    size_t mask_;
+    std::unique_ptr<std::atomic<T*>[]> slots_;
+};
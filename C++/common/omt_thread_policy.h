@@ -0,0 +1,214 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+/*  omt_thread_policy.h pins the calling thread to CPUs or a NUMA node, optionally raises it to
+	SCHED_FIFO, and reads per-thread context switch counters from /proc.
+
+	Pinning, NUMA placement and /proc counters are Linux only. Elsewhere omtThreadApplyPolicy
+	reports the settings as unsupported and the counters read as unavailable.  */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+struct OMTThreadPolicy
+{
+    // CPUs the thread may run on. Empty leaves it to the OS, or to numaNode if set.
+    std::vector<int> cpus;
+
+    // Restrict the thread to the CPUs of this NUMA node when cpus is empty, -1 for no restriction
+    int numaNode = -1;
+
+    // SCHED_FIFO priority (1-99), 0 keeps the default time-sharing policy
+    int fifoPriority = 0;
+};
+
+struct OMTThreadSwitches
+{
+    long voluntary;
+    long involuntary;
+};
+
+// Parses a CPU list such as "2", "2,3" or "4-7,12" into cpus. Returns false on malformed input.
+inline bool omtThreadParseCpuList(const char* list, std::vector<int>& cpus)
+{
+    cpus.clear();
+    const char* p = list;
+    while (*p)
+    {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0)
+        {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first)
+            {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back((int)cpu);
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p != '\0' && *p != '\n')
+        {
+            return false;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return !cpus.empty();
+}
+
+// Kernel thread id of the calling thread, as used in /proc/self/task
+inline int omtThreadId()
+{
+#ifdef __linux__
+    return (int)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+// Applies policy to the calling thread. Returns false and describes the failure in error if any
+// part could not be applied; the remaining parts are still attempted.
+inline bool omtThreadApplyPolicy(const OMTThreadPolicy& policy, std::string& error)
+{
+    bool ok = true;
+    error.clear();
+
+    std::vector<int> cpus = policy.cpus;
+#ifdef __linux__
+    if (cpus.empty() && policy.numaNode >= 0)
+    {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", policy.numaNode);
+        FILE* f = fopen(path, "r");
+        char list[1024] = {};
+        if (!f || !fgets(list, sizeof(list), f) || !omtThreadParseCpuList(list, cpus))
+        {
+            error += "unknown NUMA node; ";
+            ok = false;
+        }
+        if (f)
+        {
+            fclose(f);
+        }
+    }
+
+    if (!cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (size_t i = 0; i < cpus.size(); i++)
+        {
+            if (cpus[i] < CPU_SETSIZE)
+            {
+                CPU_SET(cpus[i], &set);
+            }
+        }
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        {
+            error += "affinity rejected; ";
+            ok = false;
+        }
+    }
+#else
+    if (!cpus.empty() || policy.numaNode >= 0)
+    {
+        error += "CPU pinning not supported on this platform; ";
+        ok = false;
+    }
+#endif
+
+    if (policy.fifoPriority > 0)
+    {
+        sched_param param = {};
+        param.sched_priority = policy.fifoPriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+        {
+            error += "SCHED_FIFO rejected (needs CAP_SYS_NICE or an rtprio limit); ";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Reads voluntary and involuntary context switch counts of a thread of this process.
+inline bool omtThreadReadSwitches(int threadId, OMTThreadSwitches& switches)
+{
+    switches.voluntary = -1;
+    switches.involuntary = -1;
+#ifdef __linux__
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", threadId);
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        if (!strncmp(line, "voluntary_ctxt_switches:", 24))
+        {
+            switches.voluntary = strtol(line + 24, NULL, 10);
+        }
+        else if (!strncmp(line, "nonvoluntary_ctxt_switches:", 27))
+        {
+            switches.involuntary = strtol(line + 27, NULL, 10);
+        }
+    }
+    fclose(f);
+    return switches.involuntary >= 0;
+#else
+    (void)threadId;
+    return false;
+#endif
+}
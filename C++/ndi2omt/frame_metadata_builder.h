@@ -0,0 +1,101 @@
+/*
+ * Fixed-capacity XML builder for OMT metadata
+ * The buffer is allocated once, so building per-frame metadata never touches
+ * the heap. Elements that do not fit are rolled back whole, keeping the
+ * output well-formed; callers can check dropped() to report truncation.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "libomt.h"
+
+class FrameMetadataBuilder {
+public:
+    // OMT accepts up to 65536 bytes of per-frame metadata including the null terminator
+    static const size_t kMaxLength = 65536;
+
+    FrameMetadataBuilder() : buffer_(new char[kMaxLength]), length_(0), reserved_(0), dropped_(0) {
+        buffer_[0] = '\0';
+    }
+
+    ~FrameMetadataBuilder() {
+        delete[] buffer_;
+    }
+
+    void reset() {
+        length_ = 0;
+        reserved_ = 0;
+        buffer_[0] = '\0';
+    }
+
+    bool empty() const { return length_ == 0; }
+    size_t length() const { return length_; }
+    const char* c_str() const { return buffer_; }
+
+    // Number of elements rolled back because they did not fit, since construction
+    uint64_t dropped() const { return dropped_; }
+
+    // Space held back for closing tags that will be appended later
+    void reserve_tail(size_t bytes) { reserved_ += bytes; }
+    void release_tail(size_t bytes) { reserved_ = bytes < reserved_ ? reserved_ - bytes : 0; }
+
+    size_t mark() const { return length_; }
+
+    void rollback(size_t mark) {
+        length_ = mark;
+        buffer_[length_] = '\0';
+        dropped_++;
+    }
+
+    bool append(const char* text, size_t length) {
+        if (length_ + length + reserved_ + 1 > kMaxLength) {
+            return false;
+        }
+        memcpy(buffer_ + length_, text, length);
+        length_ += length;
+        buffer_[length_] = '\0';
+        return true;
+    }
+
+    bool append(const char* text) {
+        return append(text, strlen(text));
+    }
+
+    bool append_uint(uint64_t value) {
+        char digits[24];
+        int n = snprintf(digits, sizeof(digits), "%llu", (unsigned long long)value);
+        return append(digits, (size_t)n);
+    }
+
+    bool append_hex(uint8_t value) {
+        static const char hex[] = "0123456789ABCDEF";
+        char pair[2] = { hex[value >> 4], hex[value & 0x0F] };
+        return append(pair, 2);
+    }
+
+    // Points the frame at the built XML, or clears its metadata when nothing was added.
+    // The builder must outlive the omt_send call that uses the frame.
+    void attach(OMTMediaFrame& frame) const {
+        if (length_ == 0) {
+            frame.FrameMetadata = nullptr;
+            frame.FrameMetadataLength = 0;
+        } else {
+            frame.FrameMetadata = buffer_;
+            frame.FrameMetadataLength = (int)length_ + 1;
+        }
+    }
+
+private:
+    FrameMetadataBuilder(const FrameMetadataBuilder&);
+    FrameMetadataBuilder& operator=(const FrameMetadataBuilder&);
+
+    char* buffer_;
+    size_t length_;
+    size_t reserved_;
+    uint64_t dropped_;
+};
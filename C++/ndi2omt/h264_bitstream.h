@@ -0,0 +1,192 @@
+/*
+ * H.264 bitstream packing detection and conversion for the NDI to OMT converter
+ * Some NDI HX senders deliver length-prefixed NAL units (AVCC, as stored in MP4/MOV)
+ * rather than Annex-B start codes. These helpers detect the packing of an access unit
+ * and rewrite it in either direction. The frame belongs to the NDI SDK, so AVCC is always
+ * copied out as Annex-B; four byte start codes and four byte lengths are the same size, so
+ * that copy turns back into AVCC in place.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "h264_nal.h"
+
+enum H264Packing {
+    H264Packing_Unknown,
+    H264Packing_AnnexB,
+    H264Packing_Avcc
+};
+
+inline uint32_t h264_read_length(const uint8_t* p, int length_size) {
+    uint32_t value = 0;
+    for (int i = 0; i < length_size; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+inline void h264_write_length(uint8_t* p, uint32_t value, int length_size) {
+    for (int i = length_size - 1; i >= 0; i--) {
+        p[i] = (uint8_t)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+// True when length prefixes of length_size bytes tile the buffer exactly and every NAL header
+// has forbidden_zero_bit clear and a type in the range real streams use (1..23).
+inline bool h264_avcc_is_valid(const uint8_t* data, size_t size, int length_size) {
+    size_t pos = 0;
+    if (size == 0) {
+        return false;
+    }
+    while (pos < size) {
+        if (pos + length_size > size) {
+            return false;
+        }
+        uint32_t nal_size = h264_read_length(data + pos, length_size);
+        pos += length_size;
+        if (nal_size == 0 || nal_size > size - pos) {
+            return false;
+        }
+        uint8_t header = data[pos];
+        uint8_t type = header & 0x1F;
+        if ((header & 0x80) || type == 0 || type > 23) {
+            return false;
+        }
+        pos += nal_size;
+    }
+    return true;
+}
+
+// Detects the packing of one access unit. length_size is the AVCC length size announced by the
+// stream's avcC record, or 0 if unknown; on AVCC detection it is set to the size that matched.
+inline H264Packing h264_detect_packing(const uint8_t* data, size_t size, int& length_size) {
+    if (size >= 4 && data[0] == 0 && data[1] == 0 &&
+        (data[2] == 1 || (data[2] == 0 && data[3] == 1))) {
+        return H264Packing_AnnexB;
+    }
+    if (length_size > 0) {
+        return h264_avcc_is_valid(data, size, length_size) ? H264Packing_Avcc : H264Packing_Unknown;
+    }
+    static const int candidates[3] = { 4, 2, 1 };
+    for (int i = 0; i < 3; i++) {
+        if (h264_avcc_is_valid(data, size, candidates[i])) {
+            length_size = candidates[i];
+            return H264Packing_Avcc;
+        }
+    }
+    return H264Packing_Unknown;
+}
+
+// Worst case Annex-B size of an AVCC buffer: every NAL grows from length_size to 4 bytes of prefix.
+inline size_t h264_annexb_capacity(size_t size, int length_size) {
+    return size + (size / (length_size + 1) + 1) * (4 - length_size);
+}
+
+// Worst case AVCC size of an Annex-B buffer: three byte start codes grow to four byte lengths.
+inline size_t h264_avcc_capacity(size_t size) {
+    return size + size / 4 + 4;
+}
+
+// Copies a validated AVCC buffer with any length size into out as Annex-B with four byte start codes.
+// out must hold h264_annexb_capacity bytes. Returns the number of bytes written.
+inline size_t h264_avcc_to_annexb(const uint8_t* data, size_t size, int length_size, uint8_t* out) {
+    size_t pos = 0, written = 0;
+    while (pos + length_size <= size) {
+        uint32_t nal_size = h264_read_length(data + pos, length_size);
+        pos += length_size;
+        out[written] = 0;
+        out[written + 1] = 0;
+        out[written + 2] = 0;
+        out[written + 3] = 1;
+        memcpy(out + written + 4, data + pos, nal_size);
+        written += 4 + nal_size;
+        pos += nal_size;
+    }
+    return written;
+}
+
+// Rewrites four byte start codes as four byte AVCC lengths in place. Zero bytes ahead of a start
+// code stay with the preceding NAL. Every start code must be four bytes long, as h264_avcc_to_annexb
+// writes them.
+inline void h264_annexb_to_avcc_inplace(uint8_t* data, size_t size) {
+    size_t prefix = 0;
+    while (prefix < size) {
+        size_t sc = h264_find_start_code(data, size, prefix + 4);
+        size_t next_prefix = (sc < size) ? sc - 1 : size;
+        h264_write_length(data + prefix, (uint32_t)(next_prefix - prefix - 4), 4);
+        prefix = next_prefix;
+    }
+}
+
+// Copies an Annex-B buffer into out as AVCC with four byte lengths. out must hold
+// h264_avcc_capacity bytes. Returns the number of bytes written.
+inline size_t h264_annexb_to_avcc(const uint8_t* data, size_t size, uint8_t* out) {
+    H264NalIterator nals(data, size);
+    H264Nal nal;
+    size_t written = 0;
+    while (nals.next(nal)) {
+        h264_write_length(out + written, (uint32_t)nal.size, 4);
+        memcpy(out + written + 4, nal.data, nal.size);
+        written += 4 + nal.size;
+    }
+    return written;
+}
+
+// Reads an AVCDecoderConfigurationRecord (ISO/IEC 14496-15 5.3.3.1): the NAL length size
+// and the SPS/PPS it carries.
+class H264AvccConfig {
+public:
+    H264AvccConfig() : data_(nullptr), size_(0), pos_(0), length_size_(0), remaining_sps_(0), remaining_pps_(0) {}
+
+    bool parse(const uint8_t* data, size_t size) {
+        if (size < 7 || data[0] != 1) {
+            return false;
+        }
+        data_ = data;
+        size_ = size;
+        length_size_ = (data[4] & 0x03) + 1;
+        remaining_sps_ = data[5] & 0x1F;
+        remaining_pps_ = -1;  // count follows the SPS entries
+        pos_ = 6;
+        return length_size_ != 3;
+    }
+
+    int length_size() const { return length_size_; }
+
+    // Returns each SPS, then each PPS of the record.
+    bool next(H264Nal& nal) {
+        if (remaining_sps_ == 0 && remaining_pps_ < 0) {
+            if (pos_ >= size_) {
+                return false;
+            }
+            remaining_pps_ = data_[pos_++];
+        }
+        int& remaining = (remaining_sps_ > 0) ? remaining_sps_ : remaining_pps_;
+        if (remaining <= 0 || pos_ + 2 > size_) {
+            return false;
+        }
+        size_t nal_size = h264_read_length(data_ + pos_, 2);
+        pos_ += 2;
+        if (nal_size == 0 || nal_size > size_ - pos_) {
+            return false;
+        }
+        nal.data = data_ + pos_;
+        nal.size = nal_size;
+        pos_ += nal_size;
+        remaining--;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+    int length_size_;
+    int remaining_sps_;
+    int remaining_pps_;
+};
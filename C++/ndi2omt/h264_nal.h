@@ -0,0 +1,135 @@
+/*
+ * H.264 NAL unit helpers for the NDI to OMT converter
+ * Zero-copy iteration over Annex-B byte streams and emulation-prevention
+ * aware reading of NAL payloads (RBSP). Nothing here allocates, so it is
+ * safe to run on every frame in the capture loop.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// NAL unit types used by the converter (ITU-T H.264 Table 7-1)
+enum H264NalType {
+    H264Nal_Slice = 1,
+    H264Nal_IDR = 5,
+    H264Nal_SEI = 6,
+    H264Nal_SPS = 7,
+    H264Nal_PPS = 8,
+    H264Nal_AUD = 9
+};
+
+struct H264Nal {
+    const uint8_t* data;  // NAL header byte, i.e. the first byte after the start code
+    size_t size;          // Header plus payload, trailing zero bytes removed
+
+    uint8_t type() const { return data[0] & 0x1F; }
+    uint8_t ref_idc() const { return (data[0] >> 5) & 0x03; }
+};
+
+// Returns the offset of the next 00 00 01 start code at or after pos, or size if there is none.
+// memchr finds the 0x01 candidates, which keeps the scan close to memory bandwidth on large slices.
+inline size_t h264_find_start_code(const uint8_t* data, size_t size, size_t pos) {
+    while (pos + 3 <= size) {
+        const uint8_t* one = (const uint8_t*)memchr(data + pos + 2, 0x01, size - pos - 2);
+        if (!one) {
+            return size;
+        }
+        size_t at = one - data;
+        if (data[at - 1] == 0 && data[at - 2] == 0) {
+            return at - 2;
+        }
+        pos = at - 1;
+    }
+    return size;
+}
+
+// Walks the NAL units of an Annex-B byte stream without copying.
+// Bytes before the first start code are ignored.
+class H264NalIterator {
+public:
+    H264NalIterator(const uint8_t* data, size_t size)
+        : data_(data), size_(size), pos_(size) {
+        size_t sc = h264_find_start_code(data, size, 0);
+        if (sc < size) {
+            pos_ = sc + 3;
+        }
+    }
+
+    bool next(H264Nal& nal) {
+        while (pos_ < size_) {
+            size_t begin = pos_;
+            size_t sc = h264_find_start_code(data_, size_, begin);
+            size_t end = sc;
+            // A four byte start code leaves its leading zero on the previous NAL
+            while (end > begin && data_[end - 1] == 0) {
+                end--;
+            }
+            pos_ = (sc < size_) ? sc + 3 : size_;
+            if (end > begin) {
+                nal.data = data_ + begin;
+                nal.size = end - begin;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Type of the next NAL unit, read without searching for its end. -1 once exhausted.
+    int peek_type() const {
+        return (pos_ < size_) ? (data_[pos_] & 0x1F) : -1;
+    }
+
+    // Returns the next NAL unit extended to the end of the buffer and ends the iteration.
+    // Lets slice headers be parsed without scanning the slice data for the next start code.
+    bool next_unbounded(H264Nal& nal) {
+        if (pos_ >= size_) {
+            return false;
+        }
+        nal.data = data_ + pos_;
+        nal.size = size_ - pos_;
+        pos_ = size_;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+// Reads RBSP bytes from a NAL payload, dropping emulation prevention bytes (00 00 03) on the fly.
+class H264RbspReader {
+public:
+    H264RbspReader(const uint8_t* data, size_t size)
+        : data_(data), size_(size), pos_(0), zeros_(0) {}
+
+    bool read_byte(uint8_t& value) {
+        if (pos_ < size_ && zeros_ >= 2 && data_[pos_] == 0x03) {
+            pos_++;
+            zeros_ = 0;
+        }
+        if (pos_ >= size_) {
+            return false;
+        }
+        value = data_[pos_++];
+        zeros_ = (value == 0) ? zeros_ + 1 : 0;
+        return true;
+    }
+
+    // True while at least one payload byte remains before the rbsp_trailing_bits
+    bool more_data() const {
+        if (pos_ >= size_) {
+            return false;
+        }
+        return !(pos_ + 1 == size_ && data_[pos_] == 0x80);
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+    int zeros_;
+};
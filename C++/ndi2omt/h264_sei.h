@@ -0,0 +1,84 @@
+/*
+ * H.264 SEI message parsing for the NDI to OMT converter
+ * Iterates the sei_message() entries of an SEI NAL unit (ITU-T H.264 7.3.2.3)
+ * and exposes each payload as an RBSP byte stream, without copying.
+ */
+
+#pragma once
+
+#include "h264_nal.h"
+
+// SEI payload types forwarded or inspected by the converter (ITU-T H.264 Annex D)
+enum H264SeiType {
+    H264Sei_PicTiming = 1,
+    H264Sei_UserDataRegistered = 4,  // ITU-T T.35, carries CEA-608/708 captions
+    H264Sei_UserDataUnregistered = 5,
+    H264Sei_RecoveryPoint = 6
+};
+
+class H264SeiParser {
+public:
+    explicit H264SeiParser(const H264Nal& nal)
+        : rbsp_(nal.data + 1, nal.size > 0 ? nal.size - 1 : 0), remaining_(0) {}
+
+    // Advances to the next message, skipping any payload bytes the caller did not read.
+    bool next(uint32_t& payload_type, uint32_t& payload_size) {
+        uint8_t b;
+        while (remaining_ > 0) {
+            if (!rbsp_.read_byte(b)) {
+                return false;
+            }
+            remaining_--;
+        }
+        if (!rbsp_.more_data()) {
+            return false;
+        }
+        if (!read_value(payload_type) || !read_value(payload_size)) {
+            return false;
+        }
+        remaining_ = payload_size;
+        return true;
+    }
+
+    // Reads the next byte of the current message payload.
+    bool read_payload_byte(uint8_t& value) {
+        if (remaining_ == 0 || !rbsp_.read_byte(value)) {
+            return false;
+        }
+        remaining_--;
+        return true;
+    }
+
+private:
+    // payloadType and payloadSize are coded as a run of 0xFF bytes plus a final byte
+    bool read_value(uint32_t& value) {
+        uint8_t b;
+        value = 0;
+        do {
+            if (!rbsp_.read_byte(b)) {
+                return false;
+            }
+            value += b;
+        } while (b == 0xFF);
+        return true;
+    }
+
+    H264RbspReader rbsp_;
+    uint32_t remaining_;
+};
+
+// T.35 user data with the ATSC "GA94" identifier holds CEA-708 closed captions.
+// Takes the parser by value so the caller's read position is left untouched.
+inline bool h264_sei_is_cea708(H264SeiParser parser, uint32_t payload_type, uint32_t payload_size) {
+    static const uint8_t prefix[7] = { 0xB5, 0x00, 0x31, 'G', 'A', '9', '4' };
+    if (payload_type != H264Sei_UserDataRegistered || payload_size < sizeof(prefix)) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(prefix); i++) {
+        uint8_t b;
+        if (!parser.read_payload_byte(b) || b != prefix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
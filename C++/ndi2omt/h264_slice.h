@@ -0,0 +1,347 @@
+/*
+ * H.264 slice header parsing and reference chain tracking for the NDI to OMT converter
+ * Parses just enough of the SPS, PPS and slice header (ITU-T H.264 7.3.2.1, 7.3.2.2, 7.3.3)
+ * to recover frame_num, nal_ref_idc, picture order count and slice type, then checks
+ * frame_num continuity (7.4.3) to detect pictures lost upstream. Parameter sets are
+ * stored in fixed tables and the bit reader works in place, so nothing allocates.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "h264_nal.h"
+
+// Big-endian bit reader over RBSP data; emulation prevention bytes are removed by H264RbspReader.
+// Reads past the end return zero bits and set the error flag.
+class H264BitReader {
+public:
+    H264BitReader(const uint8_t* data, size_t size)
+        : rbsp_(data, size), cache_(0), bits_(0), error_(false) {}
+
+    bool error() const { return error_; }
+
+    uint32_t read_bits(int count) {
+        uint32_t value = 0;
+        for (int i = 0; i < count; i++) {
+            value = (value << 1) | read_bit();
+        }
+        return value;
+    }
+
+    uint32_t read_bit() {
+        if (bits_ == 0) {
+            uint8_t b;
+            if (!rbsp_.read_byte(b)) {
+                error_ = true;
+                return 0;
+            }
+            cache_ = b;
+            bits_ = 8;
+        }
+        bits_--;
+        return (cache_ >> bits_) & 1;
+    }
+
+    // ue(v) Exp-Golomb
+    uint32_t read_ue() {
+        int leading_zeros = 0;
+        while (read_bit() == 0) {
+            if (error_ || ++leading_zeros > 31) {
+                error_ = true;
+                return 0;
+            }
+        }
+        if (leading_zeros == 0) {
+            return 0;
+        }
+        return ((1u << leading_zeros) - 1) + read_bits(leading_zeros);
+    }
+
+    // se(v) Exp-Golomb
+    int32_t read_se() {
+        uint32_t code = read_ue();
+        return (code & 1) ? (int32_t)((code + 1) / 2) : -(int32_t)(code / 2);
+    }
+
+private:
+    H264RbspReader rbsp_;
+    uint32_t cache_;
+    int bits_;
+    bool error_;
+};
+
+enum H264SliceType {
+    H264Slice_P = 0,
+    H264Slice_B = 1,
+    H264Slice_I = 2,
+    H264Slice_SP = 3,
+    H264Slice_SI = 4
+};
+
+struct H264Sps {
+    bool valid;
+    bool separate_colour_plane;
+    bool frame_mbs_only;
+    bool gaps_in_frame_num_allowed;
+    bool delta_pic_order_always_zero;
+    uint32_t log2_max_frame_num;
+    uint32_t pic_order_cnt_type;
+    uint32_t log2_max_poc_lsb;
+};
+
+struct H264Pps {
+    bool valid;
+    uint32_t sps_id;
+    bool bottom_field_pic_order_in_frame_present;
+};
+
+struct H264SliceHeader {
+    uint32_t first_mb_in_slice;
+    H264SliceType slice_type;
+    uint8_t nal_ref_idc;
+    bool idr;
+    uint32_t frame_num;
+    bool field_pic;
+    bool bottom_field;
+    uint32_t pic_order_cnt_lsb;
+    const H264Sps* sps;
+};
+
+// Active SPS/PPS tables, filled as parameter sets pass through the stream
+class H264ParameterSets {
+public:
+    H264ParameterSets() {
+        for (int i = 0; i < kMaxSps; i++) sps_[i].valid = false;
+        for (int i = 0; i < kMaxPps; i++) pps_[i].valid = false;
+    }
+
+    bool parse_sps(const H264Nal& nal) {
+        H264BitReader br(nal.data + 1, nal.size - 1);
+        uint32_t profile_idc = br.read_bits(8);
+        br.read_bits(16);  // constraint flags, level_idc
+        uint32_t sps_id = br.read_ue();
+        if (br.error() || sps_id >= (uint32_t)kMaxSps) {
+            return false;
+        }
+
+        H264Sps sps = {};
+        if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 || profile_idc == 244 ||
+            profile_idc == 44 || profile_idc == 83 || profile_idc == 86 || profile_idc == 118 ||
+            profile_idc == 128 || profile_idc == 138 || profile_idc == 139 || profile_idc == 134 ||
+            profile_idc == 135) {
+            uint32_t chroma_format_idc = br.read_ue();
+            if (chroma_format_idc == 3) {
+                sps.separate_colour_plane = br.read_bit() != 0;
+            }
+            br.read_ue();   // bit_depth_luma_minus8
+            br.read_ue();   // bit_depth_chroma_minus8
+            br.read_bit();  // qpprime_y_zero_transform_bypass_flag
+            if (br.read_bit()) {  // seq_scaling_matrix_present_flag
+                int lists = (chroma_format_idc != 3) ? 8 : 12;
+                for (int i = 0; i < lists; i++) {
+                    if (br.read_bit()) {
+                        skip_scaling_list(br, i < 6 ? 16 : 64);
+                    }
+                }
+            }
+        }
+
+        sps.log2_max_frame_num = br.read_ue() + 4;
+        sps.pic_order_cnt_type = br.read_ue();
+        if (sps.pic_order_cnt_type == 0) {
+            sps.log2_max_poc_lsb = br.read_ue() + 4;
+        } else if (sps.pic_order_cnt_type == 1) {
+            sps.delta_pic_order_always_zero = br.read_bit() != 0;
+            br.read_se();  // offset_for_non_ref_pic
+            br.read_se();  // offset_for_top_to_bottom_field
+            uint32_t cycle = br.read_ue();
+            for (uint32_t i = 0; i < cycle && !br.error(); i++) {
+                br.read_se();
+            }
+        }
+        br.read_ue();  // max_num_ref_frames
+        sps.gaps_in_frame_num_allowed = br.read_bit() != 0;
+        br.read_ue();  // pic_width_in_mbs_minus1
+        br.read_ue();  // pic_height_in_map_units_minus1
+        sps.frame_mbs_only = br.read_bit() != 0;
+
+        if (br.error() || sps.log2_max_frame_num > 16 || sps.pic_order_cnt_type > 2 ||
+            (sps.pic_order_cnt_type == 0 && sps.log2_max_poc_lsb > 16)) {
+            return false;
+        }
+        sps.valid = true;
+        sps_[sps_id] = sps;
+        return true;
+    }
+
+    bool parse_pps(const H264Nal& nal) {
+        H264BitReader br(nal.data + 1, nal.size - 1);
+        uint32_t pps_id = br.read_ue();
+        uint32_t sps_id = br.read_ue();
+        br.read_bit();  // entropy_coding_mode_flag
+        bool bottom_field_pic_order = br.read_bit() != 0;
+        if (br.error() || pps_id >= (uint32_t)kMaxPps || sps_id >= (uint32_t)kMaxSps) {
+            return false;
+        }
+        pps_[pps_id].valid = true;
+        pps_[pps_id].sps_id = sps_id;
+        pps_[pps_id].bottom_field_pic_order_in_frame_present = bottom_field_pic_order;
+        return true;
+    }
+
+    // Parses the leading fields of a slice header. Only the first bytes of the NAL are read,
+    // so nal.size may extend to the end of the buffer.
+    bool parse_slice_header(const H264Nal& nal, H264SliceHeader& header) const {
+        H264BitReader br(nal.data + 1, nal.size - 1);
+        header.nal_ref_idc = nal.ref_idc();
+        header.idr = nal.type() == H264Nal_IDR;
+        header.first_mb_in_slice = br.read_ue();
+        uint32_t slice_type = br.read_ue();
+        uint32_t pps_id = br.read_ue();
+        if (br.error() || slice_type > 9 || pps_id >= (uint32_t)kMaxPps || !pps_[pps_id].valid) {
+            return false;
+        }
+        const H264Pps& pps = pps_[pps_id];
+        const H264Sps& sps = sps_[pps.sps_id];
+        if (!sps.valid) {
+            return false;
+        }
+
+        header.slice_type = (H264SliceType)(slice_type % 5);
+        header.sps = &sps;
+        if (sps.separate_colour_plane) {
+            br.read_bits(2);  // colour_plane_id
+        }
+        header.frame_num = br.read_bits((int)sps.log2_max_frame_num);
+        header.field_pic = false;
+        header.bottom_field = false;
+        if (!sps.frame_mbs_only) {
+            header.field_pic = br.read_bit() != 0;
+            if (header.field_pic) {
+                header.bottom_field = br.read_bit() != 0;
+            }
+        }
+        if (header.idr) {
+            br.read_ue();  // idr_pic_id
+        }
+        header.pic_order_cnt_lsb = 0;
+        if (sps.pic_order_cnt_type == 0) {
+            header.pic_order_cnt_lsb = br.read_bits((int)sps.log2_max_poc_lsb);
+        }
+        return !br.error();
+    }
+
+private:
+    static const int kMaxSps = 32;
+    static const int kMaxPps = 256;
+
+    static void skip_scaling_list(H264BitReader& br, int size) {
+        int32_t last_scale = 8, next_scale = 8;
+        for (int j = 0; j < size && !br.error(); j++) {
+            if (next_scale != 0) {
+                next_scale = (last_scale + br.read_se() + 256) % 256;
+            }
+            last_scale = (next_scale == 0) ? last_scale : next_scale;
+        }
+    }
+
+    H264Sps sps_[kMaxSps];
+    H264Pps pps_[kMaxPps];
+};
+
+// Follows frame_num from picture to picture. A reference picture must carry PrevRefFrameNum
+// or PrevRefFrameNum + 1 (modulo MaxFrameNum); anything else means pictures were lost.
+// After a gap the chain stays broken until an IDR or a recovery point.
+class H264ReferenceTracker {
+public:
+    H264ReferenceTracker()
+        : have_reference_(false), broken_(false), prev_ref_frame_num_(0),
+          prev_poc_msb_(0), prev_poc_lsb_(0), prev_frame_num_(0), frame_num_offset_(0),
+          gaps_(0), missing_frames_(0), last_poc_(0) {}
+
+    // Returns false when the picture depends on a broken reference chain.
+    bool on_picture(const H264SliceHeader& header, bool recovery_point) {
+        const H264Sps& sps = *header.sps;
+        uint32_t max_frame_num = 1u << sps.log2_max_frame_num;
+
+        if (header.idr) {
+            have_reference_ = true;
+            broken_ = false;
+            prev_poc_msb_ = 0;
+            prev_poc_lsb_ = 0;
+            frame_num_offset_ = 0;
+        } else if (have_reference_ && !sps.gaps_in_frame_num_allowed) {
+            uint32_t expected = (prev_ref_frame_num_ + 1) % max_frame_num;
+            if (header.frame_num != prev_ref_frame_num_ && header.frame_num != expected) {
+                gaps_++;
+                missing_frames_ += (header.frame_num + max_frame_num - expected) % max_frame_num;
+                broken_ = true;
+            }
+        } else if (!have_reference_) {
+            // Joined mid-stream: nothing can be decoded until the first IDR or recovery point
+            broken_ = true;
+        }
+
+        if (recovery_point && broken_) {
+            broken_ = false;
+            have_reference_ = true;
+        }
+
+        update_poc(header, max_frame_num);
+
+        if (header.nal_ref_idc != 0) {
+            prev_ref_frame_num_ = header.frame_num;
+        }
+        prev_frame_num_ = header.frame_num;
+        return !broken_;
+    }
+
+    bool broken() const { return broken_; }
+    uint64_t gaps() const { return gaps_; }
+    uint64_t missing_frames() const { return missing_frames_; }
+
+    // Picture order count of the last picture (top field/frame), for pic_order_cnt_type 0 and 2
+    int64_t last_poc() const { return last_poc_; }
+
+private:
+    // ITU-T H.264 8.2.1.1 and 8.2.1.3. Type 1 is not tracked and reports frame_num instead.
+    void update_poc(const H264SliceHeader& header, uint32_t max_frame_num) {
+        const H264Sps& sps = *header.sps;
+        if (sps.pic_order_cnt_type == 0) {
+            int64_t max_lsb = (int64_t)1 << sps.log2_max_poc_lsb;
+            int64_t lsb = header.pic_order_cnt_lsb;
+            int64_t msb = prev_poc_msb_;
+            if (lsb < prev_poc_lsb_ && prev_poc_lsb_ - lsb >= max_lsb / 2) {
+                msb += max_lsb;
+            } else if (lsb > prev_poc_lsb_ && lsb - prev_poc_lsb_ > max_lsb / 2) {
+                msb -= max_lsb;
+            }
+            last_poc_ = msb + lsb;
+            if (header.nal_ref_idc != 0) {
+                prev_poc_msb_ = msb;
+                prev_poc_lsb_ = lsb;
+            }
+        } else if (sps.pic_order_cnt_type == 2) {
+            if (!header.idr && header.frame_num < prev_frame_num_) {
+                frame_num_offset_ += max_frame_num;
+            }
+            int64_t poc = 2 * (frame_num_offset_ + header.frame_num);
+            last_poc_ = (header.nal_ref_idc == 0) ? poc - 1 : poc;
+        } else {
+            last_poc_ = header.frame_num;
+        }
+    }
+
+    bool have_reference_;
+    bool broken_;
+    uint32_t prev_ref_frame_num_;
+    int64_t prev_poc_msb_;
+    int64_t prev_poc_lsb_;
+    uint32_t prev_frame_num_;
+    int64_t frame_num_offset_;
+    uint64_t gaps_;
+    uint64_t missing_frames_;
+    int64_t last_poc_;
+};
@@ -13,6 +13,7 @@
  */
 
 #include <iostream>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <chrono>
@@ -20,8 +21,10 @@
 #include <atomic>
 #include <signal.h>
 #include <mutex>
+#include <condition_variable>
 #include <queue>
 #include <map>
+#include <memory>
 
 // NDI Advanced SDK
 #include <Processing.NDI.Advanced.h>
@@ -30,8 +33,52 @@
 // OMT SDK
 #include "libomt.h"
 
+#include "h264_nal.h"
+#include "h264_bitstream.h"
+#include "h264_sei.h"
+#include "h264_slice.h"
+#include "frame_metadata_builder.h"
+#include "../common/omt_frame_pool.h"
+#include "../common/omt_thread_policy.h"
+#include "../common/omt_control_plane.h"
+
 std::atomic<bool> running(true);
 
+// How NDI metadata frames reach the OMT output
+enum MetadataMode {
+    MetadataMode_Off,
+    MetadataMode_Forward,  // Each NDI metadata frame becomes an OMT metadata frame
+    MetadataMode_Attach    // NDI metadata frames are batched into the next video frame's FrameMetadata
+};
+
+// What to do with pictures whose reference chain is broken by lost packets
+enum GapPolicy {
+    GapPolicy_Suppress,  // Hold back pictures until an IDR or recovery point arrives
+    GapPolicy_Forward    // Count the gap but forward everything
+};
+
+// NAL packing of the H.264 handed to OMT
+enum BitstreamFormat {
+    BitstreamFormat_AnnexB,  // Start codes, as decoders reading raw .h264 expect
+    BitstreamFormat_Avcc     // Four byte length prefixes, as MP4/MOV recorders expect
+};
+
+struct ConverterOptions {
+    MetadataMode metadata_mode = MetadataMode_Forward;
+    bool forward_sei = true;
+    GapPolicy gap_policy = GapPolicy_Suppress;
+    BitstreamFormat bitstream_format = BitstreamFormat_AnnexB;
+    OMTFramePoolOptions pool_options;
+    
+    // Placement of the converter threads; --numa-node applies to threads without explicit CPUs
+    OMTThreadPolicy capture_policy;
+    OMTThreadPolicy send_policy;
+    OMTThreadPolicy reporter_policy;
+};
+
+static const char kFrameMetadataOpen[] = "<ndi2omt>";
+static const char kFrameMetadataClose[] = "</ndi2omt>";
+
 void signal_handler(int) {
     std::cout << "\nShutdown signal received..." << std::endl;
     running = false;
@@ -45,10 +92,49 @@ private:
     
     // OMT Components
     omt_send_t* omt_sender;
+    std::unique_ptr<OMTSendControl> send_control;  // Tally, connections and statistics, driven by the reporter thread
     
     // Stream info
     std::string ndi_source_name;
     std::string omt_stream_name;
+    ConverterOptions options;
+    
+    // A video frame on its way from the capture thread to the send thread. The NDI frame stays
+    // allocated until the send thread has handed it to OMT.
+    struct OutgoingFrame {
+        NDIlib_video_frame_v2_t ndi_frame;
+        OMTMediaFrame omt_frame;
+        FrameMetadataBuilder metadata;   // Preallocated, so per-frame metadata never allocates
+        uint8_t* bitstream_buffer = nullptr;  // Pooled copy of the access unit when it had to be repacked
+        uint8_t* h264_data = nullptr;
+        size_t h264_size = 0;
+        bool is_keyframe = false;
+        bool is_bframe = false;
+    };
+    
+    // Capture -> send handoff. Slots cycle through free_slots and send_queue.
+    static const int kOutgoingFrames = 4;
+    OutgoingFrame outgoing_frames[kOutgoingFrames];
+    OutgoingFrame* current = nullptr;  // Slot being filled by the capture thread
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::queue<int> free_slots;
+    std::queue<int> send_queue;
+    
+    // Kernel thread ids for the context switch report
+    std::atomic<int> capture_thread_id{0};
+    std::atomic<int> send_thread_id{0};
+    std::atomic<int> reporter_thread_id{0};
+    
+    FrameMetadataBuilder pending_metadata;  // NDI metadata frames waiting for the next video frame
+    
+    // H.264 stream state for reference gap detection
+    H264ParameterSets parameter_sets;
+    H264ReferenceTracker reference_tracker;
+    
+    // Bitstream normalization. Repacked frames go into pooled buffers held until the frame is sent.
+    int avcc_length_size = 0;  // From the sender's avcC record, 0 until one is seen
+    OMTFramePool frame_pool;
     
     // Statistics
     std::atomic<int> frames_received{0};
@@ -58,24 +144,46 @@ private:
     std::atomic<int> connections{0};
     std::atomic<int> keyframes_sent{0};
     std::atomic<int> pframes_sent{0};
+    std::atomic<int> bframes_sent{0};
+    std::atomic<int> frames_suppressed{0};
+    std::atomic<int> annexb_frames{0};
+    std::atomic<int> avcc_frames{0};
+    std::atomic<int> repacked_in_place{0};
+    std::atomic<int> repacked_copied{0};
     std::atomic<int> frames_dropped{0};
+    std::atomic<int> metadata_forwarded{0};
+    std::atomic<int> sei_forwarded{0};
+    std::atomic<int> metadata_truncated{0};
+    std::atomic<uint64_t> reference_gaps{0};
+    std::atomic<uint64_t> reference_missing{0};
     
-    // Stream properties
-    int current_width = 0;
-    int current_height = 0;
-    int current_fps_n = 30;
-    int current_fps_d = 1;
+    // Stream properties: written by the capture thread, read by the reporter
+    std::atomic<int> current_width{0};
+    std::atomic<int> current_height{0};
+    std::atomic<int> current_fps_n{30};
+    std::atomic<int> current_fps_d{1};
     
     std::chrono::high_resolution_clock::time_point start_time;
     std::chrono::high_resolution_clock::time_point last_stats_time;
 
 public:
-    NDIToOMTConverter(const std::string& ndi_source, const std::string& omt_stream)
+    NDIToOMTConverter(const std::string& ndi_source, const std::string& omt_stream,
+                      const ConverterOptions& converter_options)
         : ndi_receiver(nullptr), ndi_finder(nullptr), omt_sender(nullptr),
-          ndi_source_name(ndi_source), omt_stream_name(omt_stream) {
+          ndi_source_name(ndi_source), omt_stream_name(omt_stream), options(converter_options),
+          frame_pool(converter_options.pool_options) {
         
         start_time = std::chrono::high_resolution_clock::now();
         last_stats_time = start_time;
+        
+        for (int i = 0; i < kOutgoingFrames; i++) {
+            outgoing_frames[i].omt_frame.Type = OMTFrameType_Video;
+            outgoing_frames[i].omt_frame.Codec = OMTCodec_VMX1;  // Use VMX1 as H.264 marker
+            outgoing_frames[i].omt_frame.ColorSpace = OMTColorSpace_BT709;
+            outgoing_frames[i].omt_frame.Flags = OMTVideoFlags_None;
+            outgoing_frames[i].omt_frame.Timestamp = -1;  // Auto timestamp
+            free_slots.push(i);
+        }
     }
     
     ~NDIToOMTConverter() {
@@ -200,29 +308,27 @@ public:
         strcpy(info.Manufacturer, "OMT Bridge");
         strcpy(info.Version, "1.0");
         omt_send_setsenderinformation(omt_sender, &info);
+        send_control.reset(new OMTSendControl(omt_sender, 100));
         
         std::cout << "OMT sender created: " << omt_stream_name << std::endl;
         
         return true;
     }
     
+    // Runs the capture loop on the calling thread, with OMT sends and statistics on their own threads
+    // so that neither a blocking omt_send nor console output can delay NDI capture.
     void run() {
         std::cout << "Starting conversion loop..." << std::endl;
         
+        std::thread send_thread(&NDIToOMTConverter::send_loop, this);
+        std::thread reporter_thread(&NDIToOMTConverter::reporter_loop, this);
+        apply_thread_policy("capture", options.capture_policy, capture_thread_id);
+        
         // NDI frame structures
         NDIlib_video_frame_v2_t video_frame;
         NDIlib_audio_frame_v3_t audio_frame;
         NDIlib_metadata_frame_t metadata_frame;
         
-        // OMT frame structure
-        OMTMediaFrame omt_frame = {};
-        omt_frame.Type = OMTFrameType_Video;
-        omt_frame.Codec = OMTCodec_VMX1;  // Use VMX1 as H.264 marker
-        omt_frame.ColorSpace = OMTColorSpace_BT709;
-        omt_frame.Flags = OMTVideoFlags_None;
-        omt_frame.Timestamp = -1;  // Auto timestamp
-        
-        auto last_connection_check = std::chrono::high_resolution_clock::now();
         bool warned_about_compression = false;
         
         while (running) {
@@ -253,8 +359,10 @@ public:
                         warned_about_compression = true;
                     }
                     
-                    handle_video_frame(video_frame, omt_frame);
-                    NDIlib_recv_free_video_v2(ndi_receiver, &video_frame);
+                    // Queued frames are freed by the send thread once OMT has them
+                    if (!handle_video_frame(video_frame)) {
+                        NDIlib_recv_free_video_v2(ndi_receiver, &video_frame);
+                    }
                     break;
                 }
                 
@@ -265,7 +373,7 @@ public:
                 }
                 
                 case NDIlib_frame_type_metadata: {
-                    // Handle metadata if needed
+                    handle_metadata_frame(metadata_frame);
                     NDIlib_recv_free_metadata(ndi_receiver, &metadata_frame);
                     break;
                 }
@@ -285,20 +393,309 @@ public:
                 default:
                     break;
             }
+        }
+        
+        {
+            // Taking the lock orders the wakeup after any wait that saw running still set
+            std::lock_guard<std::mutex> lock(queue_mutex);
+        }
+        queue_cv.notify_all();
+        send_thread.join();
+        reporter_thread.join();
+        
+        std::cout << "Conversion loop ended" << std::endl;
+    }
+    
+    void apply_thread_policy(const char* role, OMTThreadPolicy policy, std::atomic<int>& thread_id) {
+        thread_id = omtThreadId();
+        if (policy.cpus.empty() && policy.numaNode < 0) {
+            policy.numaNode = options.pool_options.numaNode;
+        }
+        if (policy.cpus.empty() && policy.numaNode < 0 && policy.fifoPriority == 0) {
+            return;
+        }
+        std::string error;
+        if (!omtThreadApplyPolicy(policy, error)) {
+            std::cerr << "Thread policy for " << role << " thread not fully applied: " << error << std::endl;
+        }
+    }
+    
+    // Takes the next free handoff slot, waiting for the send thread if all are in flight.
+    // Returns nullptr only when shutting down.
+    OutgoingFrame* acquire_outgoing_frame() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_cv.wait(lock, [this] { return !free_slots.empty() || !running; });
+        if (free_slots.empty()) {
+            return nullptr;
+        }
+        int slot = free_slots.front();
+        free_slots.pop();
+        return &outgoing_frames[slot];
+    }
+    
+    void return_outgoing_frame(OutgoingFrame* frame) {
+        frame_pool.release(frame->bitstream_buffer);
+        frame->bitstream_buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            free_slots.push((int)(frame - outgoing_frames));
+        }
+        queue_cv.notify_all();
+    }
+    
+    void queue_outgoing_frame(OutgoingFrame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            send_queue.push((int)(frame - outgoing_frames));
+        }
+        queue_cv.notify_all();
+    }
+    
+    void send_loop() {
+        apply_thread_policy("send", options.send_policy, send_thread_id);
+        
+        while (true) {
+            int slot;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [this] { return !send_queue.empty() || !running; });
+                if (send_queue.empty()) {
+                    break;
+                }
+                slot = send_queue.front();
+                send_queue.pop();
+            }
             
-            // Update connection count periodically
-            auto now = std::chrono::high_resolution_clock::now();
-            if (now - last_connection_check >= std::chrono::seconds(1)) {
-                connections = omt_send_connections(omt_sender);
-                last_connection_check = now;
-                print_statistics();
+            // Frames still queued at shutdown are released without sending
+            OutgoingFrame& frame = outgoing_frames[slot];
+            if (running) {
+                send_compressed_to_omt(frame.h264_data, frame.h264_size, frame.is_keyframe, frame.is_bframe,
+                                       frame.omt_frame);
             }
+            NDIlib_recv_free_video_v2(ndi_receiver, &frame.ndi_frame);
+            return_outgoing_frame(&frame);
         }
+    }
+    
+    void reporter_loop() {
+        apply_thread_policy("reporter", options.reporter_policy, reporter_thread_id);
         
-        std::cout << "Conversion loop ended" << std::endl;
+        while (running) {
+            // Waits in the tally and metadata calls, so this loop needs no sleep of its own
+            send_control->poll();
+            connections = send_control->snapshot().connections;
+            print_statistics();
+        }
+    }
+    
+    void handle_metadata_frame(const NDIlib_metadata_frame_t& ndi_metadata) {
+        if (options.metadata_mode == MetadataMode_Off || !ndi_metadata.p_data) {
+            return;
+        }
+        
+        size_t text_length = strlen(ndi_metadata.p_data);
+        if (text_length == 0) {
+            return;
+        }
+        
+        if (options.metadata_mode == MetadataMode_Forward) {
+            OMTMediaFrame omt_metadata = {};
+            omt_metadata.Type = OMTFrameType_Metadata;
+            omt_metadata.Timestamp = -1;
+            omt_metadata.Data = ndi_metadata.p_data;
+            omt_metadata.DataLength = (int)text_length + 1;
+            if (omt_send(omt_sender, &omt_metadata) >= 0) {
+                metadata_forwarded++;
+            }
+            return;
+        }
+        
+        // Attach mode: batch into the FrameMetadata of the next video frame
+        size_t mark = pending_metadata.mark();
+        if (pending_metadata.append(ndi_metadata.p_data, text_length)) {
+            metadata_forwarded++;
+        } else {
+            pending_metadata.rollback(mark);
+            metadata_truncated++;
+        }
+    }
+    
+    // NDI can carry the codec configuration as extra data after the bitstream, either as an
+    // avcC record or as Annex-B SPS/PPS. Learn the AVCC length size and the parameter sets from it.
+    void apply_codec_config(const uint8_t* config, size_t config_size) {
+        H264AvccConfig avcc;
+        H264Nal nal;
+        if (avcc.parse(config, config_size)) {
+            avcc_length_size = avcc.length_size();
+            while (avcc.next(nal)) {
+                if (nal.type() == H264Nal_SPS) {
+                    parameter_sets.parse_sps(nal);
+                } else if (nal.type() == H264Nal_PPS) {
+                    parameter_sets.parse_pps(nal);
+                }
+            }
+            return;
+        }
+        
+        H264NalIterator nals(config, config_size);
+        while (nals.next(nal)) {
+            if (nal.type() == H264Nal_SPS) {
+                parameter_sets.parse_sps(nal);
+            } else if (nal.type() == H264Nal_PPS) {
+                parameter_sets.parse_pps(nal);
+            }
+        }
     }
     
-    void handle_video_frame(const NDIlib_video_frame_v2_t& ndi_frame, OMTMediaFrame& omt_frame) {
+    // Brings the access unit into Annex-B for analysis. The NDI frame is only borrowed from the SDK and
+    // is never written, so AVCC is repacked into a pooled bitstream_buffer. Returns false if the packing
+    // was not recognised.
+    bool normalize_to_annexb(uint8_t*& h264_data, size_t& h264_size) {
+        int length_size = avcc_length_size;
+        H264Packing packing = h264_detect_packing(h264_data, h264_size, length_size);
+        if (packing == H264Packing_AnnexB) {
+            annexb_frames++;
+            return true;
+        }
+        if (packing != H264Packing_Avcc) {
+            return false;
+        }
+        
+        avcc_frames++;
+        current->bitstream_buffer = (uint8_t*)frame_pool.acquireBytes(h264_annexb_capacity(h264_size, length_size));
+        if (!current->bitstream_buffer) {
+            return false;
+        }
+        h264_size = h264_avcc_to_annexb(h264_data, h264_size, length_size, current->bitstream_buffer);
+        h264_data = current->bitstream_buffer;
+        repacked_copied++;
+        return true;
+    }
+    
+    // Repacks the analysed Annex-B access unit into the format requested for the OMT output.
+    void pack_for_output(uint8_t*& h264_data, size_t& h264_size) {
+        if (options.bitstream_format != BitstreamFormat_Avcc) {
+            return;
+        }
+        
+        // Our own buffer, which normalize_to_annexb filled with four byte start codes, can be rewritten
+        // in place; the NDI buffer is copied
+        if (h264_data == current->bitstream_buffer) {
+            h264_annexb_to_avcc_inplace(h264_data, h264_size);
+            repacked_in_place++;
+            return;
+        }
+        
+        current->bitstream_buffer = (uint8_t*)frame_pool.acquireBytes(h264_avcc_capacity(h264_size));
+        if (!current->bitstream_buffer) {
+            return;
+        }
+        h264_size = h264_annexb_to_avcc(h264_data, h264_size, current->bitstream_buffer);
+        h264_data = current->bitstream_buffer;
+        repacked_copied++;
+    }
+
+    
+    // Per-frame FrameMetadata is assembled in two steps around the bitstream pass:
+    // SEI messages are appended while walking the NAL units, then finish_frame_metadata adds
+    // the batched NDI metadata frames and the NDI per-frame metadata and closes the root.
+    void begin_frame_metadata() {
+        current->metadata.reset();
+        current->metadata.append(kFrameMetadataOpen, sizeof(kFrameMetadataOpen) - 1);
+        current->metadata.reserve_tail(sizeof(kFrameMetadataClose) - 1);
+    }
+    
+    void finish_frame_metadata(const NDIlib_video_frame_v2_t& ndi_frame) {
+        if (!pending_metadata.empty()) {
+            size_t mark = current->metadata.mark();
+            if (!current->metadata.append(pending_metadata.c_str(), pending_metadata.length())) {
+                current->metadata.rollback(mark);
+                metadata_truncated++;
+            }
+            pending_metadata.reset();
+        }
+        
+        if (options.metadata_mode != MetadataMode_Off && ndi_frame.p_metadata && ndi_frame.p_metadata[0]) {
+            size_t mark = current->metadata.mark();
+            if (!(current->metadata.append("<ndi>") && current->metadata.append(ndi_frame.p_metadata) &&
+                  current->metadata.append("</ndi>"))) {
+                current->metadata.rollback(mark);
+                metadata_truncated++;
+            }
+        }
+        
+        current->metadata.release_tail(sizeof(kFrameMetadataClose) - 1);
+        if (current->metadata.length() == sizeof(kFrameMetadataOpen) - 1) {
+            current->metadata.reset();
+        } else {
+            current->metadata.append(kFrameMetadataClose, sizeof(kFrameMetadataClose) - 1);
+        }
+        current->metadata.attach(current->omt_frame);
+    }
+    
+    // One pass over the NAL units ahead of the first slice: stores parameter sets, forwards SEI
+    // and parses the first slice header. Returns false if the access unit has no usable slice.
+    bool analyze_access_unit(const uint8_t* h264_data, size_t h264_size,
+                             H264SliceHeader& slice, bool& recovery_point) {
+        H264NalIterator nals(h264_data, h264_size);
+        H264Nal nal;
+        recovery_point = false;
+        
+        int nal_type;
+        while ((nal_type = nals.peek_type()) >= 0) {
+            // Only the slice header is needed, so never scan the slice data itself
+            if (nal_type == H264Nal_Slice || nal_type == H264Nal_IDR) {
+                return nals.next_unbounded(nal) && parameter_sets.parse_slice_header(nal, slice);
+            }
+            if (!nals.next(nal)) {
+                break;
+            }
+            if (nal_type == H264Nal_SPS) {
+                parameter_sets.parse_sps(nal);
+            } else if (nal_type == H264Nal_PPS) {
+                parameter_sets.parse_pps(nal);
+            } else if (nal_type == H264Nal_SEI) {
+                append_sei_messages(nal, recovery_point);
+            }
+        }
+        return false;
+    }
+    
+    // Adds each SEI message as <sei type="N">HEX</sei>; T.35 captions are tagged kind="cea708".
+    void append_sei_messages(const H264Nal& nal, bool& recovery_point) {
+        H264SeiParser sei(nal);
+        uint32_t payload_type = 0, payload_size = 0;
+        while (sei.next(payload_type, payload_size)) {
+            if (payload_type == H264Sei_RecoveryPoint) {
+                recovery_point = true;
+            }
+            if (!options.forward_sei) {
+                continue;
+            }
+            
+            size_t mark = current->metadata.mark();
+            bool ok = current->metadata.append("<sei type=\"") && current->metadata.append_uint(payload_type) &&
+                      current->metadata.append("\"");
+            if (ok && h264_sei_is_cea708(sei, payload_type, payload_size)) {
+                ok = current->metadata.append(" kind=\"cea708\"");
+            }
+            ok = ok && current->metadata.append(">");
+            uint8_t b;
+            while (ok && sei.read_payload_byte(b)) {
+                ok = current->metadata.append_hex(b);
+            }
+            ok = ok && current->metadata.append("</sei>");
+            if (ok) {
+                sei_forwarded++;
+            } else {
+                current->metadata.rollback(mark);
+                metadata_truncated++;
+            }
+        }
+    }
+    
+    // Returns true when the frame was queued for sending; the send thread then frees it.
+    bool handle_video_frame(const NDIlib_video_frame_v2_t& ndi_frame) {
         frames_received++;
         
         // Update stream properties if changed
@@ -321,15 +718,17 @@ public:
         
         // NDI HX streams can be detected by checking the FourCC or other properties
         // Let's try to handle this as compressed data first
-        if (handle_compressed_frame(ndi_frame, omt_frame)) {
-            return;
+        bool queued = false;
+        if (handle_compressed_frame(ndi_frame, queued)) {
+            return queued;
         }
         
         // If compressed handling failed, this might be uncompressed
         std::cout << "Warning: Could not extract compressed H.264 from NDI HX stream" << std::endl;
+        return false;
     }
     
-    bool handle_compressed_frame(const NDIlib_video_frame_v2_t& ndi_frame, OMTMediaFrame& omt_frame) {
+    bool handle_compressed_frame(const NDIlib_video_frame_v2_t& ndi_frame, bool& queued) {
         if (!ndi_frame.p_data || ndi_frame.data_size_in_bytes == 0) {
             return false;
         }
@@ -359,14 +758,33 @@ public:
             }
             
             // Calculate H.264 data pointer and size
-            const uint8_t* h264_data = (const uint8_t*)ndi_frame.p_data + sizeof(NDIlib_compressed_packet_t);
+            uint8_t* h264_data = ndi_frame.p_data + sizeof(NDIlib_compressed_packet_t);
             size_t h264_size = ndi_frame.data_size_in_bytes - (int)sizeof(NDIlib_compressed_packet_t);
             
+            // The bitstream is data_size bytes, followed by extra_data_size bytes of codec configuration
+            if (packet->data_size > 0 && (size_t)packet->data_size + packet->extra_data_size <= h264_size) {
+                if (packet->extra_data_size > 0) {
+                    apply_codec_config(h264_data + packet->data_size, packet->extra_data_size);
+                }
+                h264_size = packet->data_size;
+            }
+            
             std::cout << "  H.264 data size: " << h264_size << " bytes" << std::endl;
             
             // Check if this is a keyframe
             bool is_keyframe = (packet->flags & NDIlib_compressed_packet_flags_keyframe) != 0;
             
+            // Everything from here on is prepared in a handoff slot for the send thread
+            current = acquire_outgoing_frame();
+            if (!current) {
+                return true;
+            }
+            
+            // Length-prefixed (AVCC) senders are rewritten to Annex-B before any analysis
+            if (!normalize_to_annexb(h264_data, h264_size)) {
+                std::cout << "⚠️  Unrecognised H.264 packing (neither Annex-B nor AVCC)" << std::endl;
+            }
+            
             // Verify H.264 start codes and get frame type
             bool has_start_codes = false;
             std::string frame_type = "Unknown";
@@ -420,9 +838,55 @@ public:
                 std::cout << std::endl;
             }
             
-            // Send the H.264 data to OMT
-            bool sent_successfully = send_compressed_to_omt(h264_data, h264_size, is_keyframe, omt_frame);
-            (void)sent_successfully;  // Suppress unused variable warning
+            // Parse parameter sets, SEI and the slice header; SEI goes into the frame metadata
+            begin_frame_metadata();
+            H264SliceHeader slice = {};
+            bool recovery_point = false;
+            bool has_slice = analyze_access_unit(h264_data, h264_size, slice, recovery_point);
+            
+            bool is_bframe = false;
+            if (has_slice) {
+                static const char* const slice_names[] = { "P", "B", "I", "SP", "SI" };
+                bool chain_intact = reference_tracker.on_picture(slice, recovery_point);
+                reference_gaps = reference_tracker.gaps();
+                reference_missing = reference_tracker.missing_frames();
+                is_bframe = slice.slice_type == H264Slice_B;
+                std::cout << "    Slice: " << slice_names[slice.slice_type]
+                          << ", frame_num " << slice.frame_num
+                          << ", nal_ref_idc " << (int)slice.nal_ref_idc
+                          << ", POC " << reference_tracker.last_poc() << std::endl;
+                
+                if (!chain_intact) {
+                    std::cout << "⚠️  Reference chain broken (" << reference_tracker.gaps() << " gaps, "
+                              << reference_tracker.missing_frames() << " frames missing)" << std::endl;
+                    if (options.gap_policy == GapPolicy_Suppress) {
+                        // Drop SEI of the suppressed picture but keep batched NDI metadata for the next one
+                        frames_suppressed++;
+                        return_outgoing_frame(current);
+                        return true;
+                    }
+                }
+            }
+            
+            // Carry NDI metadata and SEI (captions, timecode) along with the frame
+            finish_frame_metadata(ndi_frame);
+            
+            pack_for_output(h264_data, h264_size);
+            
+            // Hand the H.264 data to the send thread
+            current->ndi_frame = ndi_frame;
+            current->h264_data = h264_data;
+            current->h264_size = h264_size;
+            current->is_keyframe = is_keyframe;
+            current->is_bframe = is_bframe;
+            current->omt_frame.Width = current_width;
+            current->omt_frame.Height = current_height;
+            current->omt_frame.FrameRateN = current_fps_n;
+            current->omt_frame.FrameRateD = current_fps_d;
+            current->omt_frame.AspectRatio = (float)current_width / current_height;
+            queue_outgoing_frame(current);
+            current = nullptr;
+            queued = true;
             
             // Always return true if we successfully extracted H.264 data
             // (even if OMT send failed - that's a different issue)
@@ -435,16 +899,9 @@ public:
     }
     
     bool send_compressed_to_omt(const void* h264_data, size_t data_size, 
-                               bool is_keyframe, OMTMediaFrame& omt_frame) {
-        
-        // Set up OMT frame for compressed H.264 data
-        omt_frame.Width = current_width;
-        omt_frame.Height = current_height;
-        omt_frame.FrameRateN = current_fps_n;
-        omt_frame.FrameRateD = current_fps_d;
-        omt_frame.AspectRatio = (float)current_width / current_height;
+                               bool is_keyframe, bool is_bframe, OMTMediaFrame& omt_frame) {
         
-        // Set compressed data
+        // Set compressed data; the format was filled in by the capture thread
         omt_frame.Data = (uint8_t*)h264_data;
         omt_frame.DataLength = data_size;
         omt_frame.CompressedData = nullptr;
@@ -456,6 +913,10 @@ public:
             omt_frame.Flags = OMTVideoFlags_None;  // Keyframe
             keyframes_sent++;
             std::cout << "🔑 Sending I-frame (" << data_size << " bytes) - Total I-frames: " << keyframes_sent << std::endl;
+        } else if (is_bframe) {
+            omt_frame.Flags = OMTVideoFlags_None;
+            bframes_sent++;
+            std::cout << "📽️  Sending B-frame (" << data_size << " bytes) - Total B-frames: " << bframes_sent << std::endl;
         } else {
             omt_frame.Flags = OMTVideoFlags_None;  // P-frame (same flag?)
             pframes_sent++;
@@ -489,7 +950,7 @@ public:
             std::cout << "   ❌ Failed to send frame to OMT (error: " << bytes_sent_result << ")" << std::endl;
             
             // Add more diagnostics
-            int conn_count = omt_send_connections(omt_sender);
+            int conn_count = send_control->snapshot().connections;
             std::cout << "      Current OMT connections: " << conn_count << std::endl;
             
             if (conn_count == 0) {
@@ -500,6 +961,15 @@ public:
         }
     }
     
+    void print_thread_switches(const char* role, int thread_id) {
+        OMTThreadSwitches switches;
+        if (thread_id != 0 && omtThreadReadSwitches(thread_id, switches)) {
+            std::cout << " " << role << " " << switches.voluntary << "/" << switches.involuntary;
+        } else {
+            std::cout << " " << role << " n/a";
+        }
+    }
+    
     void print_statistics() {
         auto now = std::chrono::high_resolution_clock::now();
         if (now - last_stats_time >= std::chrono::seconds(2)) {  // More frequent updates
@@ -517,7 +987,15 @@ public:
                 std::cout << "  Total frames: " << frames_received << " received, " 
                           << frames_sent << " sent, " << frames_dropped << " dropped" << std::endl;
                 std::cout << "  Frame types: " << keyframes_sent << " I-frames, " 
-                          << pframes_sent << " P-frames" << std::endl;
+                          << pframes_sent << " P-frames, " << bframes_sent << " B-frames" << std::endl;
+                std::cout << "  Bitstream: " << annexb_frames << " Annex-B, " << avcc_frames << " AVCC in, "
+                          << repacked_in_place << " repacked in place, " << repacked_copied << " copied" << std::endl;
+                OMTFramePoolStats pool_stats = frame_pool.stats();
+                std::cout << "  Buffer pool: " << pool_stats.hits << " hits, " << pool_stats.misses << " misses, "
+                          << pool_stats.residentBytes / (1024 * 1024) << " MB resident" << std::endl;
+                std::cout << "  Reference gaps: " << reference_gaps << " ("
+                          << reference_missing << " frames missing), "
+                          << frames_suppressed << " frames suppressed" << std::endl;
                 std::cout << "  I/P ratio: " << (pframes_sent > 0 ? (float)keyframes_sent / pframes_sent : 0) 
                           << " (lower = more P-frames)" << std::endl;
                 std::cout << "  Success rate: " << (frames_received > 0 ? (100.0f * frames_sent / frames_received) : 0) << "%" << std::endl;
@@ -525,7 +1003,18 @@ public:
                           << avg_fps_sent << " out" << std::endl;
                 std::cout << "  Bitrate: " << mbps_received << " Mbps in, " 
                           << mbps_sent << " Mbps out" << std::endl;
-                std::cout << "  OMT Connections: " << connections << std::endl;
+                std::cout << "  Metadata: " << metadata_forwarded << " NDI frames, "
+                          << sei_forwarded << " SEI messages forwarded, "
+                          << metadata_truncated << " truncated" << std::endl;
+                OMTSendControlSnapshot control = send_control->snapshot();
+                std::cout << "  OMT Connections: " << connections << ", tally preview " << control.tally.preview
+                          << " program " << control.tally.program << ", " << control.metadataFrames
+                          << " metadata frames from receivers" << std::endl;
+                std::cout << "  Context switches (voluntary/involuntary):";
+                print_thread_switches("capture", capture_thread_id);
+                print_thread_switches("send", send_thread_id);
+                print_thread_switches("reporter", reporter_thread_id);
+                std::cout << std::endl;
                 std::cout << "  Format: " << current_width << "x" << current_height 
                           << " @ " << (float)current_fps_n / current_fps_d << " fps" << std::endl;
                 std::cout << "========================\n" << std::endl;
@@ -570,6 +1059,7 @@ public:
             ndi_finder = nullptr;
         }
         
+        send_control.reset();
         if (omt_sender) {
             omt_send_destroy(omt_sender);
             omt_sender = nullptr;
@@ -587,6 +1077,17 @@ void print_usage(const char* program_name) {
     std::cout << "  -s <source>    NDI source name (partial match)" << std::endl;
     std::cout << "  -o <output>    OMT stream name (default: NDItoOMT)" << std::endl;
     std::cout << "  -l             List available NDI sources and exit" << std::endl;
+    std::cout << "  -m <mode>      NDI metadata passthrough: forward (default), attach, off" << std::endl;
+    std::cout << "  --no-sei       Do not attach H.264 SEI messages as frame metadata" << std::endl;
+    std::cout << "  --gap-policy <p>  On lost reference frames: suppress (default) until recovery, or forward" << std::endl;
+    std::cout << "  --bitstream <f>   H.264 packing sent to OMT: annexb (default) or avcc" << std::endl;
+    std::cout << "  --hugepages       Back frame buffers with huge pages" << std::endl;
+    std::cout << "  --numa-node <n>   Allocate frame buffers and run unpinned threads on NUMA node n" << std::endl;
+    std::cout << "  --cpu-capture <cpus>   Pin the NDI capture thread, e.g. 2 or 2-3" << std::endl;
+    std::cout << "  --cpu-send <cpus>      Pin the OMT send thread" << std::endl;
+    std::cout << "  --cpu-reporter <cpus>  Pin the statistics/connection thread" << std::endl;
+    std::cout << "  --rt-priority <n>      Run the capture thread SCHED_FIFO at priority n (1-99)" << std::endl;
+    std::cout << "  --bench-bitstream Benchmark AVCC/Annex-B repacking on a synthetic IDR and exit" << std::endl;
     std::cout << "  --help         Show this help" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
@@ -594,6 +1095,97 @@ void print_usage(const char* program_name) {
     std::cout << "  " << program_name << " -l" << std::endl;
 }
 
+// Times packing detection and AVCC <-> Annex-B repacking on a synthetic 2 MB IDR of 32 slices,
+// the shape of a large HX keyframe. A plain memcpy of the frame is included for reference.
+void run_bitstream_benchmark() {
+    const int iterations = 200;
+    const size_t slice_count = 32;
+    const size_t slice_size = 60000;  // Fits two byte AVCC lengths
+    
+    // Slice payload without zero bytes, so it never contains a start code
+    std::vector<uint8_t> payload(slice_size);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < slice_size; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        payload[i] = (uint8_t)((seed >> 24) | 1);
+    }
+    payload[0] = 0x65;  // IDR NAL header
+    
+    std::vector<uint8_t> avcc4, avcc2, annexb3;
+    for (size_t s = 0; s < slice_count; s++) {
+        size_t at = avcc4.size();
+        avcc4.resize(at + 4);
+        h264_write_length(&avcc4[at], (uint32_t)slice_size, 4);
+        avcc4.insert(avcc4.end(), payload.begin(), payload.end());
+        
+        at = avcc2.size();
+        avcc2.resize(at + 2);
+        h264_write_length(&avcc2[at], (uint32_t)slice_size, 2);
+        avcc2.insert(avcc2.end(), payload.begin(), payload.end());
+        
+        static const uint8_t short_start_code[3] = { 0, 0, 1 };
+        annexb3.insert(annexb3.end(), short_start_code, short_start_code + 3);
+        annexb3.insert(annexb3.end(), payload.begin(), payload.end());
+    }
+    std::vector<uint8_t> scratch(h264_annexb_capacity(avcc4.size(), 1) + h264_avcc_capacity(annexb3.size()));
+    
+    std::cout << "Bitstream benchmark: " << slice_count << " slices, " << avcc4.size() << " bytes, "
+              << iterations << " iterations" << std::endl;
+    
+    auto report = [&](const char* name, std::chrono::high_resolution_clock::duration elapsed, size_t bytes) {
+        double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+        printf("  %-32s %9.1f us/frame %9.1f MB/s\n", name, us, bytes / us);
+    };
+    
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        memcpy(scratch.data(), avcc4.data(), avcc4.size());
+    }
+    report("memcpy (reference)", std::chrono::high_resolution_clock::now() - t0, avcc4.size());
+    
+    int detected = 0;
+    t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        int length_size = 0;
+        detected += h264_detect_packing(avcc4.data(), avcc4.size(), length_size) == H264Packing_Avcc ? length_size : 0;
+    }
+    report("detect AVCC", std::chrono::high_resolution_clock::now() - t0, avcc4.size());
+    if (detected != 4 * iterations) {
+        std::cout << "  AVCC detection failed" << std::endl;
+    }
+    
+    // The paths normalize_to_annexb and pack_for_output take: AVCC is copied into a pooled buffer of
+    // h264_annexb_capacity bytes, and --bitstream avcc turns that copy back into AVCC in place
+    std::vector<uint8_t> annexb(h264_annexb_capacity(avcc4.size(), 4));
+    t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        h264_avcc_to_annexb(avcc4.data(), avcc4.size(), 4, annexb.data());
+    }
+    report("AVCC(4) -> Annex-B copy", std::chrono::high_resolution_clock::now() - t0, avcc4.size());
+    
+    t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        h264_avcc_to_annexb(avcc2.data(), avcc2.size(), 2, scratch.data());
+    }
+    report("AVCC(2) -> Annex-B copy", std::chrono::high_resolution_clock::now() - t0, avcc2.size());
+    
+    t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        size_t size = h264_avcc_to_annexb(avcc4.data(), avcc4.size(), 4, annexb.data());
+        h264_annexb_to_avcc_inplace(annexb.data(), size);
+    }
+    report("AVCC -> AVCC (copy, in place)", std::chrono::high_resolution_clock::now() - t0, avcc4.size());
+    if (memcmp(annexb.data(), avcc4.data(), avcc4.size()) != 0) {
+        std::cout << "  AVCC round trip mismatch" << std::endl;
+    }
+    
+    t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        h264_annexb_to_avcc(annexb3.data(), annexb3.size(), scratch.data());
+    }
+    report("Annex-B(3) -> AVCC copy", std::chrono::high_resolution_clock::now() - t0, annexb3.size());
+}
+
 void list_ndi_sources() {
     if (!NDIlib_initialize()) {
         std::cerr << "Failed to initialize NDI" << std::endl;
@@ -633,6 +1225,8 @@ int main(int argc, char* argv[]) {
     std::string ndi_source = "";
     std::string omt_stream = "NDItoOMT";
     bool list_sources = false;
+    bool bench_bitstream = false;
+    ConverterOptions options;
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -644,6 +1238,63 @@ int main(int argc, char* argv[]) {
             omt_stream = argv[++i];
         } else if (arg == "-l") {
             list_sources = true;
+        } else if (arg == "-m" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "forward") {
+                options.metadata_mode = MetadataMode_Forward;
+            } else if (mode == "attach") {
+                options.metadata_mode = MetadataMode_Attach;
+            } else if (mode == "off") {
+                options.metadata_mode = MetadataMode_Off;
+            } else {
+                std::cerr << "Unknown metadata mode: " << mode << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--no-sei") {
+            options.forward_sei = false;
+        } else if (arg == "--gap-policy" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "suppress") {
+                options.gap_policy = GapPolicy_Suppress;
+            } else if (policy == "forward") {
+                options.gap_policy = GapPolicy_Forward;
+            } else {
+                std::cerr << "Unknown gap policy: " << policy << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--bitstream" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "annexb") {
+                options.bitstream_format = BitstreamFormat_AnnexB;
+            } else if (format == "avcc") {
+                options.bitstream_format = BitstreamFormat_Avcc;
+            } else {
+                std::cerr << "Unknown bitstream format: " << format << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--hugepages") {
+            options.pool_options.hugePages = true;
+        } else if (arg == "--numa-node" && i + 1 < argc) {
+            options.pool_options.numaNode = atoi(argv[++i]);
+        } else if ((arg == "--cpu-capture" || arg == "--cpu-send" || arg == "--cpu-reporter") && i + 1 < argc) {
+            OMTThreadPolicy& policy = (arg == "--cpu-capture") ? options.capture_policy
+                                    : (arg == "--cpu-send") ? options.send_policy : options.reporter_policy;
+            if (!omtThreadParseCpuList(argv[++i], policy.cpus)) {
+                std::cerr << "Invalid CPU list for " << arg << ": " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--rt-priority" && i + 1 < argc) {
+            options.capture_policy.fifoPriority = atoi(argv[++i]);
+            if (options.capture_policy.fifoPriority < 1 || options.capture_policy.fifoPriority > 99) {
+                std::cerr << "Real-time priority must be between 1 and 99" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--bench-bitstream") {
+            bench_bitstream = true;
         } else if (arg == "--help") {
             print_usage(argv[0]);
             return 0;
@@ -659,12 +1310,17 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    if (bench_bitstream) {
+        run_bitstream_benchmark();
+        return 0;
+    }
+    
     // Set up signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
     // Create and run converter
-    NDIToOMTConverter converter(ndi_source, omt_stream);
+    NDIToOMTConverter converter(ndi_source, omt_stream, options);
     
     if (!converter.initialize()) {
         std::cerr << "Failed to initialize converter" << std::endl;
@@ -1,5 +1,19 @@
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <algorithm>
 
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -9,29 +23,982 @@ using namespace std;
 
 #include "libomt.h"
 
+// Percentile histograms for the arrival interval and latency report
+#include "../common/omt_histogram.h"
+// Sequence number and send time stamped by omtsendtest --probe/--barcode
+#include "../common/omt_latency_probe.h"
+// Pooled buffers and the queue between the receive and send threads of --relay
+#include "../common/omt_frame_pool.h"
+#include "../common/omt_spsc_queue.h"
+// Indexed file and aligned asynchronous writes for --record
+#include "../common/omt_media_file.h"
+// NV12, I420, BGRA, v210 and planar RGB output for --convert
+#include "../common/omt_receive_convert.h"
+
 
 
 // We will use this to dump info about the incoming OMT
 static int dumpOMTMediaFrameInfo(OMTMediaFrame * video);
 
+static std::atomic<bool> running(true);
+static std::mutex printMutex;
+
+static void signalHandler(int)
+{
+    running = false;
+}
+
+// --relay: a received frame is copied into a pooled slot and queued for a thread of its own to send,
+// so a stalled omt_send never delays the next omt_receive. The queue holds at most depth frames, besides
+// the one being sent; when it is full the oldest queued frame is recycled (dropoldest, the default,
+// keeping the output current) or the new one is dropped (dropnewest, keeping it continuous).
+enum RelayDropPolicy
+{
+    RelayDrop_Oldest,
+    RelayDrop_Newest
+};
+
+struct RelayFrame
+{
+    OMTMediaFrame frame;
+    void * data;
+    size_t dataCapacity;
+    void * metadata;
+    size_t metadataCapacity;
+    std::chrono::steady_clock::time_point queued;
+};
+
+struct Relay
+{
+    // depth frames can wait while one more is being sent. Both queues can hold every slot, so pushing
+    // never fails; the depth limit is kept by relayFrame, since the queue's capacity is rounded up.
+    explicit Relay(int depth) : depth(depth), queue(depth + 1), free(depth + 1), slots(depth + 1)
+    {
+        spare.reserve(slots.size());
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            slots[i].data = NULL;
+            slots[i].dataCapacity = 0;
+            slots[i].metadata = NULL;
+            slots[i].metadataCapacity = 0;
+            free.push(&slots[i]);
+        }
+    }
+
+    int depth;
+    OMTSpscQueue<RelayFrame> queue;     // receive thread to send thread
+    OMTSpscQueue<RelayFrame> free;      // send thread back to receive thread
+    std::vector<RelayFrame> slots;
+    std::vector<RelayFrame *> spare;    // slots the receive thread holds: evicted, or taken but not filled
+    RelayDropPolicy policy = RelayDrop_Oldest;
+    std::thread thread;
+
+    // the send thread sleeps here when the queue is empty
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> waiting{false};
+
+    std::atomic<int64_t> sent{0};               // per second
+    std::atomic<int64_t> depthMax{0};           // per second
+    std::atomic<int64_t> delayMaxUs{0};         // per second, queue to omt_send
+    std::atomic<int64_t> droppedOldest{0};      // whole run
+    std::atomic<int64_t> droppedNewest{0};      // whole run
+};
+
+// --record: video and audio are appended to an indexed OMT media file exactly as received (uncompressed
+// UYVY, P216 and so on, or VMX1 with nativevmx), or with --convert as converted. The receive threads only copy each frame into a pool of
+// large aligned buffers; a writer thread streams those to disk, with O_DIRECT under --direct. If the disk
+// falls behind and the buffers fill up, frames are dropped and counted (the default) or, with
+// --recordpolicy wait, the receive thread waits, which pushes the backlog upstream instead.
+struct Recorder
+{
+    std::unique_ptr<OMTMediaFileWriter> writer;
+    std::mutex mutex;               // video and audio threads share the writer
+    bool waitForDisk = false;
+    bool haveVideo = false;
+    bool haveAudio = false;
+    bool failed = false;
+
+    std::atomic<int64_t> frames{0};         // per second
+    std::atomic<int64_t> dropped{0};        // whole run
+
+    // owned by the reporting loop
+    uint64_t lastBytes = 0;
+    dev_t device = 0;
+    uint64_t lastDiskSectors = 0;
+};
+
+// Each frame type is received, dumped and looped back on its own thread. Data returned by omt_receive
+// stays valid until the next call for the same frame type, so the threads do not hold each other up:
+// a slow video send no longer delays audio.
+struct ReceiveWorker
+{
+    const char * name;
+    OMTFrameType type;
+    int heartbeatMs;            // how long one omt_receive waits while idle, and so how soon the thread sees shutdown
+    std::atomic<int> timeoutMs{0};              // the current wait, see receiveTimeoutMs
+
+    omt_receive_t * recv;
+    omt_send_t * sndloop;
+    int nativeReceiveMode;
+    int quiet;                  // dump only the first frame and format changes
+
+    std::thread thread;
+
+    // written by the worker, read and reset once per second by main
+    std::atomic<int64_t> frames{0};
+    std::atomic<int64_t> bytes{0};
+    std::atomic<int64_t> timeouts{0};
+    std::atomic<int64_t> framesTotal{0};        // whole run, for wakeups per frame
+    std::atomic<int64_t> timeoutsTotal{0};
+    std::atomic<int64_t> gapMaxUs{0};
+    std::atomic<int64_t> sendTotalUs{0};
+    std::atomic<int64_t> sendMaxUs{0};
+    std::atomic<int64_t> jitterTotalUs{0};      // distance of each inter-arrival time from the nominal frame period
+    std::atomic<int64_t> jitterSamples{0};
+    std::atomic<int64_t> formatChanges{0};
+
+    // --histogram: time between frames and, with --sharedclock, from the frame's timestamp to its arrival,
+    // in microseconds. The worker records into the live histograms and main drains them when it reports.
+    int sharedClock;
+    std::atomic<int64_t> nominalUs{0};
+    OMTHistogram intervals;
+    OMTHistogram latency;
+    OMTHistogram intervalsTotal;
+    OMTHistogram latencyTotal;
+
+    // --probe: end to end latency from the send time in the probe metadata and in the barcode
+    int probe;
+    OMTHistogram probeLatency;
+    OMTHistogram probeLatencyTotal;
+    OMTHistogram barcodeLatency;
+    OMTHistogram barcodeLatencyTotal;
+    std::atomic<int64_t> probeFrames{0};
+    std::atomic<int64_t> barcodeFrames{0};
+    std::atomic<int64_t> barcodeUnreadable{0};
+    std::atomic<int64_t> sequenceMissing{0};
+    std::atomic<int64_t> sequenceOutOfOrder{0};
+
+    // --relay: null for the original synchronous loopback
+    std::unique_ptr<Relay> relay;
+    OMTFramePool * pool;
+
+    // --record: shared by the video and audio workers, null when not recording
+    Recorder * recorder;
+
+    // --convert: video is converted into this buffer, band by band on the converter's threads. Null when
+    // not converting and for the other frame types.
+    OMTConvertWorkers * converter;
+    OMTConvertFormat convertFormat;
+    std::vector<uint8_t> converted;
+    std::atomic<int64_t> convertFrames{0};
+    std::atomic<int64_t> convertTotalUs{0};
+    std::atomic<int64_t> convertMaxUs{0};
+    std::atomic<int64_t> convertUnsupported{0};     // whole run
+};
+
+// Last sequence number seen by a worker, from metadata or, without it, the 16 bit barcode
+struct ProbeState
+{
+    bool haveSequence;
+    uint64_t lastSequence;
+    bool barcodeSeen;
+};
+
+static void countSequence(ReceiveWorker * worker, ProbeState& state, uint64_t sequence, uint64_t mask)
+{
+    if (state.haveSequence)
+    {
+        uint64_t step = (sequence - state.lastSequence) & mask;
+        if (step == 0 || step > mask / 2)
+        {
+            // repeated, late, or the sender restarted
+            worker->sequenceOutOfOrder++;
+        }
+        else
+        {
+            worker->sequenceMissing += step - 1;
+        }
+    }
+    state.haveSequence = true;
+    state.lastSequence = sequence;
+}
+
+static void checkProbe(ReceiveWorker * worker, const OMTMediaFrame * frame, ProbeState& state)
+{
+    int64_t now = omtProbeNow();
+    uint64_t sequence = 0;
+    int64_t sent = 0;
+    bool haveMetadata = omtProbeReadMetadata(frame->FrameMetadata, frame->FrameMetadataLength, sequence, sent);
+    if (haveMetadata)
+    {
+        worker->probeFrames++;
+        worker->probeLatency.record((now - sent) / 10);
+        countSequence(worker, state, sequence, ~0ULL);
+    }
+
+    // only uncompressed frames carry a readable picture
+    if (frame->Data && frame->DataLength > 0 && frame->Codec != OMTCodec_VMX1)
+    {
+        uint16_t barcodeSequence = 0;
+        if (omtProbeReadBarcode(frame->Data, frame->Codec, frame->Width, frame->Height, frame->Stride, barcodeSequence, sent, now))
+        {
+            state.barcodeSeen = true;
+            worker->barcodeFrames++;
+            worker->barcodeLatency.record((now - sent) / 10);
+            if (!haveMetadata)
+            {
+                countSequence(worker, state, barcodeSequence, 0xFFFF);
+            }
+        }
+        else if (state.barcodeSeen)
+        {
+            worker->barcodeUnreadable++;
+        }
+    }
+}
+
+// The fields that describe a stream's format, compared frame to frame to spot changes. The audio block size
+// is not one of them: at 29.97 and 59.94 it alternates from frame to frame, 1601/1602 or 800/801 at 48 kHz.
+struct FrameFormat
+{
+    int codec, width, height, frameRateN, frameRateD, flags, colorSpace;
+    int sampleRate, channels;
+};
+
+static FrameFormat frameFormat(const OMTMediaFrame * frame)
+{
+    FrameFormat format = { (int)frame->Codec, frame->Width, frame->Height, frame->FrameRateN, frame->FrameRateD, (int)frame->Flags,
+                           (int)frame->ColorSpace, frame->SampleRate, frame->Channels };
+    return format;
+}
+
+// Time one frame should take, or 0 for metadata which has no rate. Audio goes by the frame's own block size,
+// so alternating NTSC blocks are each measured against their own period.
+static int64_t nominalIntervalUs(const OMTMediaFrame * frame)
+{
+    if (frame->Type == OMTFrameType_Video && frame->FrameRateN > 0)
+    {
+        return 1000000LL * frame->FrameRateD / frame->FrameRateN;
+    }
+    if (frame->Type == OMTFrameType_Audio && frame->SampleRate > 0)
+    {
+        return 1000000LL * frame->SamplesPerChannel / frame->SampleRate;
+    }
+    return 0;
+}
+
+// How long the next omt_receive waits. While frames arrive it is two frame (or audio block) periods, so a
+// frame that is a little late does not cost an extra wakeup: 34 ms at 59.94, 84 ms at 23.98. It never goes
+// above 250 ms, to keep shutdown prompt at low frame rates. Frames without a rate use the heartbeat.
+static int receiveTimeoutMs(const OMTMediaFrame * frame, int heartbeatMs)
+{
+    int64_t periodUs = nominalIntervalUs(frame);
+    if (periodUs <= 0)
+    {
+        return heartbeatMs;
+    }
+    int64_t timeoutMs = (periodUs * 2 + 999) / 1000;
+    return timeoutMs < 1 ? 1 : (timeoutMs > 250 ? 250 : (int)timeoutMs);
+}
+
+// Receive wakeups per frame: every omt_receive returns either a frame or a timeout, so 1.00 is ideal
+static double wakeupsPerFrame(int64_t frames, int64_t timeouts)
+{
+    return frames > 0 ? (double)(frames + timeouts) / frames : 0.0;
+}
+
+static void updateMax(std::atomic<int64_t>& max, int64_t value)
+{
+    int64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Makes buffer hold at least length bytes, replacing it from the pool when it is too small
+static bool reserveRelayBuffer(OMTFramePool * pool, void *& buffer, size_t& capacity, size_t length, const OMTMediaFrame * shape)
+{
+    if (length <= capacity)
+    {
+        return true;
+    }
+    pool->release(buffer);
+    if (shape)
+    {
+        // uncompressed video keeps a size class per format
+        buffer = pool->acquire(shape->Codec, shape->Width, shape->Height, shape->Stride, length);
+        capacity = length;
+    }
+    else
+    {
+        // acquireBytes rounds up to a power of two from 4 KB, so varying sizes settle on one buffer
+        buffer = pool->acquireBytes(length);
+        capacity = 4096;
+        while (capacity < length)
+        {
+            capacity <<= 1;
+        }
+    }
+    if (!buffer)
+    {
+        capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+// Copies what the loopback needs out of the receiver's frame: in nativevmx mode only the compressed
+// payload, moved into Data for sending, otherwise the uncompressed Data. Per frame metadata comes too.
+static bool fillRelayFrame(OMTFramePool * pool, RelayFrame * slot, const OMTMediaFrame * received, int nativeReceiveMode)
+{
+    slot->frame = *received;
+    const void * data = received->Data;
+    int length = received->DataLength;
+    bool compressed = nativeReceiveMode && received->Type == OMTFrameType_Video && received->Codec == OMTCodec_VMX1;
+    if (compressed)
+    {
+        data = received->CompressedData;
+        length = received->CompressedLength;
+    }
+    slot->frame.CompressedData = NULL;
+    slot->frame.CompressedLength = 0;
+    slot->frame.Data = NULL;
+    slot->frame.DataLength = 0;
+    slot->frame.FrameMetadata = NULL;
+    slot->frame.FrameMetadataLength = 0;
+
+    if (data && length > 0)
+    {
+        bool uncompressedVideo = received->Type == OMTFrameType_Video && !compressed;
+        if (!reserveRelayBuffer(pool, slot->data, slot->dataCapacity, length, uncompressedVideo ? received : NULL))
+        {
+            return false;
+        }
+        memcpy(slot->data, data, length);
+        slot->frame.Data = slot->data;
+        slot->frame.DataLength = length;
+    }
+    if (received->FrameMetadata && received->FrameMetadataLength > 0)
+    {
+        if (!reserveRelayBuffer(pool, slot->metadata, slot->metadataCapacity, received->FrameMetadataLength, NULL))
+        {
+            return false;
+        }
+        memcpy(slot->metadata, received->FrameMetadata, received->FrameMetadataLength);
+        slot->frame.FrameMetadata = slot->metadata;
+        slot->frame.FrameMetadataLength = received->FrameMetadataLength;
+    }
+    return true;
+}
+
+// Appends a received video or audio frame to the recording, or drops it if the write buffers are full
+static void recordFrame(Recorder * recorder, const OMTMediaFrame * frame)
+{
+    const void * data = frame->Data;
+    int length = frame->DataLength;
+    if (frame->Type == OMTFrameType_Video && frame->Codec == OMTCodec_VMX1)
+    {
+        data = frame->CompressedData;
+        length = frame->CompressedLength;
+    }
+    if (!data || length <= 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(recorder->mutex);
+    if (recorder->failed)
+    {
+        return;
+    }
+    if (!recorder->waitForDisk && !recorder->writer->writable(length))
+    {
+        recorder->dropped++;
+        return;
+    }
+    OMTMediaFileHeader& header = recorder->writer->header();
+    if (frame->Type == OMTFrameType_Video && !recorder->haveVideo)
+    {
+        header.width = frame->Width;
+        header.height = frame->Height;
+        header.stride = frame->Codec == OMTCodec_VMX1 ? 0 : frame->Stride;
+        header.frameRateN = frame->FrameRateN;
+        header.frameRateD = frame->FrameRateD;
+        header.aspectRatio = frame->AspectRatio;
+        header.colorSpace = frame->ColorSpace;
+        header.videoFlags = frame->Flags;
+        recorder->haveVideo = true;
+    }
+    if (frame->Type == OMTFrameType_Audio && !recorder->haveAudio)
+    {
+        header.sampleRate = frame->SampleRate;
+        header.channels = frame->Channels;
+        recorder->haveAudio = true;
+    }
+    uint32_t info = frame->Type == OMTFrameType_Video ? (uint32_t)frame->Flags : (uint32_t)frame->SamplesPerChannel;
+    if (!recorder->writer->write(frame->Type, frame->Codec, frame->Timestamp, info, data, (uint32_t)length))
+    {
+        printf("record: write failed, recording stopped\n");
+        recorder->failed = true;
+        return;
+    }
+    recorder->frames++;
+}
+
+// Sectors written to the disk holding the recording, from /proc/diskstats. This counts every writer
+// on that disk, so it shows what the device is sustaining, not just this recording. 0 where unavailable.
+static uint64_t diskSectorsWritten(dev_t device)
+{
+    uint64_t sectors = 0;
+#ifdef __linux__
+    FILE * stats = fopen("/proc/diskstats", "r");
+    if (!stats)
+    {
+        return 0;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), stats))
+    {
+        // major minor name, then reads, reads merged, sectors read, ms reading, writes, writes merged, sectors written
+        unsigned int deviceMajor, deviceMinor;
+        unsigned long long fields[7];
+        char name[64];
+        if (sscanf(line, "%u %u %63s %llu %llu %llu %llu %llu %llu %llu", &deviceMajor, &deviceMinor, name, &fields[0], &fields[1], &fields[2],
+                   &fields[3], &fields[4], &fields[5], &fields[6]) == 10 && deviceMajor == major(device) && deviceMinor == minor(device))
+        {
+            sectors = fields[6];
+            break;
+        }
+    }
+    fclose(stats);
+#else
+    (void)device;
+#endif
+    return sectors;
+}
+
+// One line per second while recording: what reached the file, what the disk did, and what is waiting
+static void printRecordStatistics(Recorder * recorder)
+{
+    OMTAsyncWriterStats stats;
+    uint64_t position;
+    {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        stats = recorder->writer->stats();
+        position = recorder->writer->bytesWritten();
+    }
+    double fileMBps = (stats.bytesWritten - recorder->lastBytes) / 1000000.0;
+    recorder->lastBytes = stats.bytesWritten;
+    printf("record: %lld frames/s, %.1f MB/s to file", (long long)recorder->frames.exchange(0), fileMBps);
+    uint64_t sectors = diskSectorsWritten(recorder->device);
+    if (sectors)
+    {
+        if (recorder->lastDiskSectors)
+        {
+            printf(", disk %.1f MB/s", (sectors - recorder->lastDiskSectors) * 512 / 1000000.0);
+        }
+        recorder->lastDiskSectors = sectors;
+    }
+    printf(", %.1f MB buffered, %llu stalls (%.1f ms), %lld dropped%s\n",
+        (position > stats.bytesWritten ? position - stats.bytesWritten : 0) / 1000000.0,
+        (unsigned long long)stats.stalls, stats.stallMicroseconds / 1000.0, (long long)recorder->dropped.load(),
+        recorder->failed ? ", FAILED" : "");
+}
+
+// --convert: converts a received video frame into the worker's buffer and describes the result in converted.
+// Frames the format cannot be made from, such as VMX1 with nativevmx, are counted and left alone.
+static bool convertFrame(ReceiveWorker * worker, const OMTMediaFrame * received, OMTMediaFrame& converted)
+{
+    OMTConvertFormat format = worker->convertFormat;
+    size_t size = omtConvertSize(format, received->Width, received->Height);
+    if (!omtConvertSupported(received->Codec, format) || size == 0)
+    {
+        worker->convertUnsupported++;
+        return false;
+    }
+    if (worker->converted.size() < size)
+    {
+        worker->converted.resize(size);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!omtConvertFrame(received, format, &worker->converted[0], worker->converter))
+    {
+        worker->convertUnsupported++;
+        return false;
+    }
+    int64_t convertUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    worker->convertFrames++;
+    worker->convertTotalUs += convertUs;
+    updateMax(worker->convertMaxUs, convertUs);
+
+    converted = *received;
+    converted.Codec = (OMTCodec)omtConvertFormatFourCC(format);
+    converted.Stride = omtConvertStride(format, received->Width);
+    converted.Data = &worker->converted[0];
+    converted.DataLength = (int)size;
+    converted.CompressedData = NULL;
+    converted.CompressedLength = 0;
+    int flags = received->Flags & ~(OMTVideoFlags_Alpha | OMTVideoFlags_HighBitDepth);
+    if (format == OMTConvertFormat_BGRA)
+    {
+        flags |= received->Flags & OMTVideoFlags_Alpha;
+    }
+    if (format == OMTConvertFormat_V210)
+    {
+        flags |= received->Flags & OMTVideoFlags_HighBitDepth;
+    }
+    converted.Flags = (OMTVideoFlags)flags;
+    return true;
+}
+
+// --benchconvert: time to convert one synthetic frame, in frames per second
+static double benchConvertRun(const OMTMediaFrame * frame, OMTConvertFormat format, uint8_t * dst, OMTConvertWorkers * workers, bool simd, int frames)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        omtConvertFrame(frame, format, dst, workers, simd);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds > 0 ? frames / seconds : 0;
+}
+
+// --benchconvert [WxH] [frames]: converts noise in each receive format to each output format with the scalar
+// kernels on one thread, which are the reference, then with the SIMD kernels on one thread and on every
+// core. Prints the throughput of each and fails if any output differs from the reference.
+static int benchConvert(int argc, const char * argv[])
+{
+    int width = 3840;
+    int height = 2160;
+    int frames = 20;
+    for (int a = 2; a < argc; a++)
+    {
+        int w, h;
+        if (sscanf(argv[a], "%dx%d", &w, &h) == 2 && w >= 2 && h >= 2)
+        {
+            width = w & ~1;
+            height = h & ~1;
+        }
+        else if (atoi(argv[a]) > 0)
+        {
+            frames = atoi(argv[a]);
+        }
+    }
+    OMTConvertWorkers workers;
+    printf("convert benchmark: %dx%d, %d frames each, %s kernels, %d threads\n", width, height, frames, omtReceiveConvertSimd(), workers.threads());
+
+    const OMTCodec codecs[] = { OMTCodec_UYVY, OMTCodec_UYVA, OMTCodec_P216, OMTCodec_PA16, OMTCodec_BGRA };
+    const char * codecNames[] = { "UYVY", "UYVA", "P216", "PA16", "BGRA" };
+    bool allMatch = true;
+    for (int c = 0; c < 5; c++)
+    {
+        OMTCodec codec = codecs[c];
+        int stride = codec == OMTCodec_BGRA ? width * 4 : width * 2;
+        size_t plane = (size_t)stride * height;
+        size_t size = codec == OMTCodec_UYVA ? plane + (size_t)width * height
+                    : codec == OMTCodec_P216 ? plane * 2
+                    : codec == OMTCodec_PA16 ? plane * 3 : plane;
+        std::vector<uint8_t> source(size);
+        uint32_t seed = 1;
+        for (size_t i = 0; i < size; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            source[i] = (uint8_t)(seed >> 24);
+        }
+        OMTMediaFrame frame = {};
+        frame.Type = OMTFrameType_Video;
+        frame.Codec = codec;
+        frame.Width = width;
+        frame.Height = height;
+        frame.Stride = stride;
+        frame.Flags = codec == OMTCodec_UYVY ? OMTVideoFlags_None : OMTVideoFlags_Alpha;
+        frame.Data = &source[0];
+        frame.DataLength = (int)size;
+
+        for (int f = 0; f < OMTConvertFormat_Count; f++)
+        {
+            OMTConvertFormat format = (OMTConvertFormat)f;
+            if (!omtConvertSupported(codec, format))
+            {
+                continue;
+            }
+            std::vector<uint8_t> reference(omtConvertSize(format, width, height));
+            std::vector<uint8_t> output(reference.size());
+            double scalar = benchConvertRun(&frame, format, &reference[0], NULL, false, frames);
+            double simd = benchConvertRun(&frame, format, &output[0], NULL, true, frames);
+            bool match = output == reference;
+            std::fill(output.begin(), output.end(), 0);
+            double threaded = benchConvertRun(&frame, format, &output[0], &workers, true, frames);
+            match = match && output == reference;
+            allMatch = allMatch && match;
+            printf("%s -> %s: scalar %.1f fps, simd %.1f fps (x%.1f), %d threads %.1f fps (x%.1f)%s\n", codecNames[c], omtConvertFormatName(format),
+                scalar, simd, scalar > 0 ? simd / scalar : 0.0, workers.threads(), threaded, scalar > 0 ? threaded / scalar : 0.0,
+                match ? "" : ", OUTPUT DIFFERS FROM REFERENCE");
+            fflush(stdout);
+        }
+    }
+    return allMatch ? 0 : 1;
+}
+
+// Receive side of --relay: never waits for the send thread
+static void relayFrame(ReceiveWorker * worker, const OMTMediaFrame * received)
+{
+    Relay& relay = *worker->relay;
+    // Make room first. Only this thread pushes, so the queue can shrink but not grow meanwhile; if the
+    // send thread takes the oldest frame before it can be evicted, there is room anyway.
+    if (relay.queue.size() >= (size_t)relay.depth)
+    {
+        if (relay.policy == RelayDrop_Newest)
+        {
+            relay.droppedNewest++;
+            return;
+        }
+        RelayFrame * oldest = relay.queue.evict();
+        if (oldest)
+        {
+            relay.droppedOldest++;
+            relay.spare.push_back(oldest);
+        }
+    }
+    RelayFrame * slot = NULL;
+    if (!relay.spare.empty())
+    {
+        slot = relay.spare.back();
+        relay.spare.pop_back();
+    }
+    else
+    {
+        slot = relay.free.pop();
+    }
+    if (!slot)
+    {
+        // not expected: with fewer than depth queued and one being sent, a slot is free
+        relay.droppedNewest++;
+        return;
+    }
+    if (!fillRelayFrame(worker->pool, slot, received, worker->nativeReceiveMode))
+    {
+        relay.spare.push_back(slot);
+        relay.droppedNewest++;
+        return;
+    }
+    slot->queued = std::chrono::steady_clock::now();
+    relay.queue.push(slot);
+    updateMax(relay.depthMax, (int64_t)relay.queue.size());
+
+    // the fence orders the push before reading waiting, pairing with the one in relayLoop
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (relay.waiting)
+    {
+        std::lock_guard<std::mutex> lock(relay.wakeMutex);
+        relay.wake.notify_one();
+    }
+}
+
+// Send side of --relay. Drains what is queued after shutdown is signalled, then exits.
+static void relayLoop(ReceiveWorker * worker)
+{
+    Relay& relay = *worker->relay;
+    for (;;)
+    {
+        RelayFrame * slot = relay.queue.pop();
+        if (!slot)
+        {
+            if (!running)
+            {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(relay.wakeMutex);
+            relay.waiting = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            relay.wake.wait_for(lock, std::chrono::milliseconds(worker->heartbeatMs), [&relay] { return !relay.queue.empty() || !running; });
+            relay.waiting = false;
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point sendStart = std::chrono::steady_clock::now();
+        updateMax(relay.delayMaxUs, std::chrono::duration_cast<std::chrono::microseconds>(sendStart - slot->queued).count());
+        omt_send(worker->sndloop, &slot->frame);
+        int64_t sendUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sendStart).count();
+        worker->sendTotalUs += sendUs;
+        updateMax(worker->sendMaxUs, sendUs);
+        relay.sent++;
+        relay.free.push(slot);
+    }
+}
+
+static void receiveLoop(ReceiveWorker * worker)
+{
+    std::chrono::steady_clock::time_point lastArrival;
+    bool first = true;
+    FrameFormat format = {};
+    ProbeState probeState = {};
+    // Start on the heartbeat, follow the frame rate once frames arrive, and go back to the heartbeat after
+    // two timeouts in a row, when the source has stopped or gone away
+    int timeoutMs = worker->heartbeatMs;
+    int missed = 0;
+    worker->timeoutMs = timeoutMs;
+    while (running)
+    {
+        OMTMediaFrame frame = {}; // loop out frame
+        OMTMediaFrame * theOMTFrame = omt_receive(worker->recv, worker->type, timeoutMs);
+        if (!theOMTFrame)
+        {
+            worker->timeouts++;
+            worker->timeoutsTotal++;
+            if (++missed >= 2 && timeoutMs != worker->heartbeatMs)
+            {
+                timeoutMs = worker->heartbeatMs;
+                worker->timeoutMs = timeoutMs;
+            }
+            continue;
+        }
+        missed = 0;
+        int nextTimeoutMs = receiveTimeoutMs(theOMTFrame, worker->heartbeatMs);
+        if (nextTimeoutMs != timeoutMs)
+        {
+            timeoutMs = nextTimeoutMs;
+            worker->timeoutMs = timeoutMs;
+        }
+        std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+        FrameFormat current = frameFormat(theOMTFrame);
+        bool formatChanged = first || memcmp(&current, &format, sizeof(format)) != 0;
+        if (!first)
+        {
+            int64_t gapUs = std::chrono::duration_cast<std::chrono::microseconds>(arrival - lastArrival).count();
+            updateMax(worker->gapMaxUs, gapUs);
+            int64_t nominalUs = nominalIntervalUs(theOMTFrame);
+            if (nominalUs > 0 && !formatChanged)
+            {
+                worker->jitterTotalUs += gapUs > nominalUs ? gapUs - nominalUs : nominalUs - gapUs;
+                worker->jitterSamples++;
+                worker->intervals.record(gapUs);
+                worker->nominalUs = nominalUs;
+            }
+            if (formatChanged)
+            {
+                worker->formatChanges++;
+            }
+        }
+        lastArrival = arrival;
+        first = false;
+        format = current;
+
+        // A sender on a shared clock stamps frames in 100 ns units since the Unix epoch
+        if (worker->sharedClock)
+        {
+            int64_t nowTicks = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 100;
+            worker->latency.record((nowTicks - theOMTFrame->Timestamp) / 10);
+        }
+
+        if (worker->probe && theOMTFrame->Type == OMTFrameType_Video)
+        {
+            checkProbe(worker, theOMTFrame, probeState);
+        }
+
+        // dump what we got to the console, one frame at a time. Quietly only when the format changes.
+        if (!worker->quiet || formatChanged)
+        {
+            std::lock_guard<std::mutex> lock(printMutex);
+            dumpOMTMediaFrameInfo(theOMTFrame);
+        }
+
+        worker->frames++;
+        worker->framesTotal++;
+        worker->bytes += theOMTFrame->CompressedLength > 0 ? theOMTFrame->CompressedLength : theOMTFrame->DataLength;
+
+        // --convert replaces the received video in the recording; the loopback still sends what was received
+        const OMTMediaFrame * recorded = theOMTFrame;
+        OMTMediaFrame convertedFrame;
+        if (worker->converter && convertFrame(worker, theOMTFrame, convertedFrame))
+        {
+            recorded = &convertedFrame;
+        }
+
+        if (worker->recorder && theOMTFrame->Type != OMTFrameType_Metadata)
+        {
+            recordFrame(worker->recorder, recorded);
+        }
+
+        if (worker->relay)
+        {
+            relayFrame(worker, theOMTFrame);
+            continue;
+        }
+
+        // we are going to loop the OMT stream back out, so let's make a copy of the Frame
+        memcpy(&frame, theOMTFrame, sizeof(OMTMediaFrame));
+
+        // If its native VMX we need to move the ComressedData into Data and CompressedLength into DataLength
+        if (worker->nativeReceiveMode && theOMTFrame->Type == OMTFrameType_Video && theOMTFrame->Codec == OMTCodec_VMX1)
+        {
+            frame.Data = theOMTFrame->CompressedData;
+            frame.DataLength = theOMTFrame->CompressedLength;
+            frame.CompressedData = NULL;
+            frame.CompressedLength = 0;
+        }
+        std::chrono::steady_clock::time_point sendStart = std::chrono::steady_clock::now();
+        omt_send(worker->sndloop, &frame);
+        int64_t sendUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sendStart).count();
+        worker->sendTotalUs += sendUs;
+        updateMax(worker->sendMaxUs, sendUs);
+    }
+}
+
+// One line per second for --quiet: what each worker saw plus the receiver's own statistics
+static void printQuietStatistics(omt_receive_t * recv, ReceiveWorker * workers, int seconds)
+{
+    char line[1024];
+    int length = snprintf(line, sizeof(line), "t=%ds", seconds);
+    for (int i = 0; i < 3 && length < (int)sizeof(line); i++)
+    {
+        ReceiveWorker& w = workers[i];
+        int64_t frames = w.frames.exchange(0);
+        int64_t bytes = w.bytes.exchange(0);
+        int64_t jitterSamples = w.jitterSamples.exchange(0);
+        int64_t jitterTotalUs = w.jitterTotalUs.exchange(0);
+        int64_t timeouts = w.timeouts.exchange(0);
+        w.sendTotalUs.exchange(0);
+        w.sendMaxUs.exchange(0);
+        int64_t relayDropped = 0;
+        if (w.relay)
+        {
+            w.relay->sent.exchange(0);
+            w.relay->depthMax.exchange(0);
+            w.relay->delayMaxUs.exchange(0);
+            relayDropped = w.relay->droppedOldest.load() + w.relay->droppedNewest.load();
+        }
+        if (w.type == OMTFrameType_Metadata)
+        {
+            length += snprintf(line + length, sizeof(line) - length, " | %s %lld", w.name, (long long)frames);
+            continue;
+        }
+        length += snprintf(line + length, sizeof(line) - length, " | %s %lld fps %.1f Mbps jitter %.2f ms gap %.1f ms wake %.2f/frame",
+                           w.name, (long long)frames, bytes * 8 / 1000000.0,
+                           jitterSamples ? jitterTotalUs / 1000.0 / jitterSamples : 0.0, w.gapMaxUs.exchange(0) / 1000.0,
+                           wakeupsPerFrame(frames, timeouts));
+        if (w.relay && length < (int)sizeof(line))
+        {
+            length += snprintf(line + length, sizeof(line) - length, " relay dropped %lld", (long long)relayDropped);
+        }
+        if (w.converter && length < (int)sizeof(line))
+        {
+            int64_t converted = w.convertFrames.exchange(0);
+            length += snprintf(line + length, sizeof(line) - length, " convert %.2f ms", converted ? w.convertTotalUs.exchange(0) / 1000.0 / converted : 0.0);
+            w.convertMaxUs.exchange(0);
+        }
+    }
+
+    OMTStatistics video = {}, audio = {};
+    omt_receive_getvideostatistics(recv, &video);
+    omt_receive_getaudiostatistics(recv, &audio);
+    if (length < (int)sizeof(line))
+    {
+        snprintf(line + length, sizeof(line) - length, " | net %.1f Mbps, %lld dropped, %lld/%lld format changes",
+                 (video.BytesReceivedSinceLast + audio.BytesReceivedSinceLast) * 8 / 1000000.0,
+                 (long long)(video.FramesDropped + audio.FramesDropped),
+                 (long long)workers[0].formatChanges.load(), (long long)workers[1].formatChanges.load());
+    }
+    printf("%s\n", line);
+    fflush(stdout);
+}
+
+// Percentiles for the last period, or with final for the whole run. Negative latencies, which
+// mean the clocks disagree, are not in the percentiles and are counted on their own.
+static void printHistogram(const char * name, const char * what, OMTHistogram& live, OMTHistogram& total, OMTHistogram& period, bool final)
+{
+    char text[256];
+    period.reset();
+    live.drainInto(period);
+    total.add(period);
+    const OMTHistogram& shown = final ? total : period;
+    if (shown.count() || shown.below())
+    {
+        shown.format(text, sizeof(text), 1000.0);
+        printf("histogram%s %s %s: %s", final ? ".total" : "", name, what, text);
+        if (shown.below())
+        {
+            printf(", %llu negative", (unsigned long long)shown.below());
+        }
+        printf("\n");
+    }
+}
+
+static void printHistograms(ReceiveWorker * workers, bool final)
+{
+    OMTHistogram period;
+    for (int i = 0; i < 3; i++)
+    {
+        ReceiveWorker& w = workers[i];
+        char what[64];
+        snprintf(what, sizeof(what), "interval ms (nominal %.2f)", w.nominalUs / 1000.0);
+        printHistogram(w.name, what, w.intervals, w.intervalsTotal, period, final);
+        printHistogram(w.name, "latency ms", w.latency, w.latencyTotal, period, final);
+        printHistogram(w.name, "probe latency ms", w.probeLatency, w.probeLatencyTotal, period, final);
+        printHistogram(w.name, "barcode latency ms", w.barcodeLatency, w.barcodeLatencyTotal, period, final);
+        if (w.probe && w.type == OMTFrameType_Video)
+        {
+            printf("probe %s: %lld with metadata, %lld barcodes read, %lld unreadable, %lld missing, %lld out of order\n", w.name,
+                   (long long)w.probeFrames.load(), (long long)w.barcodeFrames.load(), (long long)w.barcodeUnreadable.load(),
+                   (long long)w.sequenceMissing.load(), (long long)w.sequenceOutOfOrder.load());
+        }
+    }
+    fflush(stdout);
+}
+
 
 int main(int argc, const char * argv[])
 {
 	omt_send_t * sndloop;
     int nativeReceiveMode = 0;
     int sixteenBitReceiveMode = 0;
+    int quiet = 0;
+    int histogramSeconds = 0;
+    int sharedClock = 0;
+    int probe = 0;
+    int relayDepth = 0;
+    RelayDropPolicy relayPolicy = RelayDrop_Oldest;
+    const char * recordPath = NULL;
+    int recordDirect = 0;
+    int recordWait = 0;
+    int recordBufferMB = 256;
+    int convert = 0;
+    OMTConvertFormat convertFormat = OMTConvertFormat_NV12;
+    int convertThreads = 0;
+    int heartbeatMs = 100;
     
     // optionally setup logging 
     string filename = "omtrecvtest.log";
     omt_setloggingfilename(filename.c_str());
   
   	// this example can just take a Stream name, plus it can optionally also have either nativevmx or 16bit as a second parameter 
-  	// to request compressed VMX data instead of uncompressed video, or to request specifically 16-bit uncompressed video
+  	// to request compressed VMX data instead of uncompressed video, or to request specifically 16-bit uncompressed video.
+  	// --quiet replaces the dump of every frame with one line of statistics per second, for long running monitoring.
+  	// --histogram [seconds] prints arrival interval percentiles every 10 (or the given) seconds and at exit, and
+  	// --sharedclock adds timestamp to arrival latency, for senders stamping frames from a clock synchronised with this host.
+  	// --probe reports latency and lost frames from the stamps omtsendtest --probe or --barcode adds to each video frame.
+  	// --relay [depth] sends the loopback from its own thread through a queue of depth (default 4) frames per type, and
+  	// --drop oldest|newest chooses which frame goes when that queue is full.
+  	// --record <file> writes video and audio as received to an OMT media file that omtvmxreplay can play back, buffered
+  	// in --recordbuffer MB (default 256) of aligned memory. --direct bypasses the page cache, and --recordpolicy wait
+  	// holds up receiving instead of dropping frames when the disk cannot keep up
+  	// --convert nv12|i420|bgra|v210|rgbp converts every video frame, on --convertthreads n threads (default one per core),
+  	// and reports the time it takes. With --record the converted frames are recorded instead of the received ones;
+  	// omtvmxreplay can play back nv12 and bgra recordings, but OMT cannot send i420, v210 or rgbp, so those are for other tools.
+  	// omtrecvtest --benchconvert [WxH] [frames] times the conversions against the scalar reference without a source.
+  	// --heartbeat ms sets how long each receive waits while no frames arrive (default 100), which bounds how long
+  	// shutdown takes; while frames arrive the wait follows their rate.
 	if (argc<2)
 	{
-		 printf("Usage : omtrecvtest \"HOST (OMTSOURCE)\" [nativevmx|16bit]");
+		 printf("Usage : omtrecvtest \"HOST (OMTSOURCE)\" [nativevmx|16bit] [--quiet] [--histogram [seconds]] [--sharedclock] [--probe] [--relay [depth]] [--drop oldest|newest] [--record file [--direct] [--recordpolicy drop|wait] [--recordbuffer MB]] [--convert nv12|i420|bgra|v210|rgbp [--convertthreads n]] [--heartbeat ms]\n");
+		 printf("        omtrecvtest --benchconvert [WxH] [frames]\n");
 		 exit(0);
 	}
+	if (!strcasecmp((char *)argv[1],"--benchconvert"))
+	{
+		return benchConvert(argc, argv);
+	}
 	
 	// this example receives OMT then sends it back out again through another stream.
 	// Create a loop out stream
@@ -41,16 +1008,92 @@ int main(int argc, const char * argv[])
     omt_receive_t* recv;
 
 	// check for parameters
-	if (argc>2)
+	for (int a = 2; a < argc; a++)
 	{
-		if (!strcasecmp((char *)argv[2],"nativevmx"))
+		if (!strcasecmp((char *)argv[a],"nativevmx"))
 		{
 			nativeReceiveMode  = 1;
 		}
-		if (!strcasecmp((char *)argv[2],"16bit"))
+		if (!strcasecmp((char *)argv[a],"16bit"))
 		{
 			sixteenBitReceiveMode  = 1;
 		}
+		if (!strcasecmp((char *)argv[a],"--quiet"))
+		{
+			quiet = 1;
+		}
+		if (!strcasecmp((char *)argv[a],"--histogram"))
+		{
+			histogramSeconds = 10;
+			if (a + 1 < argc && atoi(argv[a + 1]) > 0)
+			{
+				histogramSeconds = atoi(argv[++a]);
+			}
+		}
+		if (!strcasecmp((char *)argv[a],"--probe"))
+		{
+			probe = 1;
+			if (!histogramSeconds)
+			{
+				histogramSeconds = 10;
+			}
+		}
+		if (!strcasecmp((char *)argv[a],"--relay"))
+		{
+			relayDepth = 4;
+			if (a + 1 < argc && atoi(argv[a + 1]) > 0)
+			{
+				relayDepth = atoi(argv[++a]);
+			}
+		}
+		if (!strcasecmp((char *)argv[a],"--drop") && a + 1 < argc)
+		{
+			a++;
+			relayPolicy = !strcasecmp((char *)argv[a],"newest") ? RelayDrop_Newest : RelayDrop_Oldest;
+		}
+		if (!strcasecmp((char *)argv[a],"--record") && a + 1 < argc)
+		{
+			recordPath = argv[++a];
+		}
+		if (!strcasecmp((char *)argv[a],"--direct"))
+		{
+			recordDirect = 1;
+		}
+		if (!strcasecmp((char *)argv[a],"--recordpolicy") && a + 1 < argc)
+		{
+			a++;
+			recordWait = !strcasecmp((char *)argv[a],"wait");
+		}
+		if (!strcasecmp((char *)argv[a],"--recordbuffer") && a + 1 < argc)
+		{
+			recordBufferMB = atoi(argv[++a]);
+		}
+		if (!strcasecmp((char *)argv[a],"--convert") && a + 1 < argc)
+		{
+			a++;
+			if (!omtConvertFormatParse(argv[a], convertFormat))
+			{
+				printf("--convert: unknown format %s, use nv12, i420, bgra, v210 or rgbp\n", argv[a]);
+				return 1;
+			}
+			convert = 1;
+		}
+		if (!strcasecmp((char *)argv[a],"--convertthreads") && a + 1 < argc)
+		{
+			convertThreads = atoi(argv[++a]);
+		}
+		if (!strcasecmp((char *)argv[a],"--heartbeat") && a + 1 < argc && atoi(argv[a + 1]) > 0)
+		{
+			heartbeatMs = atoi(argv[++a]);
+		}
+		if (!strcasecmp((char *)argv[a],"--sharedclock"))
+		{
+			sharedClock = 1;
+			if (!histogramSeconds)
+			{
+				histogramSeconds = 10;
+			}
+		}
 	}
 
 	// setup an OMT Receiver. We specify the types of data we are interested in and then the format, and an optional flag.
@@ -71,54 +1114,175 @@ int main(int argc, const char * argv[])
 			recv = omt_receive_create((const char *)argv[1], (OMTFrameType)(OMTFrameType_Video | OMTFrameType_Audio | OMTFrameType_Metadata), (OMTPreferredVideoFormat)OMTPreferredVideoFormat_UYVYorUYVAorP216orPA16, (OMTReceiveFlags)OMTReceiveFlags_None);
 		}
 	}
- 
-    while(1)
+	if (!recv || !sndloop)
+	{
+		printf("omt_receive_create or omt_send_create failed\n");
+		return 1;
+	}
+
+    // the recording goes through chunks of 8 MB, two frames of 1080p UYVY, so a 256 MB buffer rides out
+    // about a second of the disk stalling on a 250 MB/s stream
+    Recorder recorder;
+    if (recordPath)
     {
-        OMTMediaFrame frame = {}; // loop out frame
-        OMTMediaFrame * theOMTFrame;
-        OMTFrameType t = OMTFrameType_None;
-        
-        // capture a frame of video, audio or metadata from the OMT Source
-        theOMTFrame = omt_receive(recv, (OMTFrameType)(OMTFrameType_Video | OMTFrameType_Audio | OMTFrameType_Metadata), 40);
-        if (theOMTFrame)
+        OMTAsyncWriterOptions options;
+        options.chunkBytes = 8 << 20;
+        options.chunks = recordBufferMB / 8 > 2 ? recordBufferMB / 8 : 2;
+        options.direct = recordDirect != 0;
+        recorder.writer.reset(new OMTMediaFileWriter(options));
+        recorder.waitForDisk = recordWait != 0;
+        string error;
+        if (!recorder.writer->open(recordPath, error))
+        {
+            printf("--record: %s\n", error.c_str());
+            return 1;
+        }
+        struct stat st;
+        if (stat(recordPath, &st) == 0)
         {
-            t = theOMTFrame->Type;
-            
-			// dump what we got to the console
-			dumpOMTMediaFrameInfo(theOMTFrame);
+            recorder.device = st.st_dev;
+        }
+        printf("recording to %s%s, %d MB buffer, %s when the disk falls behind\n", recordPath, recordDirect ? " (direct)" : "",
+            options.chunks * 8, recordWait ? "waiting" : "dropping frames");
+    }
 
+    std::unique_ptr<OMTConvertWorkers> converter;
+    if (convert)
+    {
+        converter.reset(new OMTConvertWorkers(convertThreads));
+        printf("converting video to %s on %d threads, %s kernels\n", omtConvertFormatName(convertFormat), converter->threads(), omtReceiveConvertSimd());
+    }
 
-			// we are going to loop the OMT stream back out, so let's make a copy of the Frame
-			memcpy(&frame,theOMTFrame,sizeof(OMTMediaFrame));
-			switch (t)
-			{
-				case OMTFrameType_Video:
-				{
-					// send it back out..  If its native VMX we need to move the ComressedData into Data and CompressedLength into DataLength
-					if (nativeReceiveMode &&  theOMTFrame->Codec == OMTCodec_VMX1)
-					{
-						frame.Data = theOMTFrame->CompressedData;
-						frame.DataLength = theOMTFrame->CompressedLength;
-						frame.CompressedData = NULL;
-						frame.CompressedLength = 0;
-					}
-					omt_send(sndloop, &frame);
-				}
-				break;
-			
-				case OMTFrameType_Audio: case OMTFrameType_Metadata:
-				{
-					omt_send(sndloop, &frame);
-				}
-				break;           
-			
-				case OMTFrameType_None: default:
-			 
-				break;
-			}
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    // one thread per frame type. Each waits for frames as long as their rate allows (see receiveTimeoutMs)
+    // and for the heartbeat while idle; metadata, which has no rate, always waits for the heartbeat.
+    OMTFramePool relayPool;
+    ReceiveWorker workers[3];
+    workers[0].name = "video";
+    workers[0].type = OMTFrameType_Video;
+    workers[1].name = "audio";
+    workers[1].type = OMTFrameType_Audio;
+    workers[2].name = "metadata";
+    workers[2].type = OMTFrameType_Metadata;
+    for (int i = 0; i < 3; i++)
+    {
+        workers[i].heartbeatMs = heartbeatMs;
+        workers[i].recv = recv;
+        workers[i].sndloop = sndloop;
+        workers[i].nativeReceiveMode = nativeReceiveMode;
+        workers[i].quiet = quiet;
+        workers[i].sharedClock = sharedClock;
+        workers[i].probe = probe;
+        workers[i].pool = &relayPool;
+        workers[i].recorder = recordPath && workers[i].type != OMTFrameType_Metadata ? &recorder : NULL;
+        workers[i].converter = workers[i].type == OMTFrameType_Video ? converter.get() : NULL;
+        workers[i].convertFormat = convertFormat;
+        if (relayDepth > 0)
+        {
+            workers[i].relay.reset(new Relay(relayDepth));
+            workers[i].relay->policy = relayPolicy;
+            workers[i].relay->thread = std::thread(relayLoop, &workers[i]);
+        }
+        workers[i].thread = std::thread(receiveLoop, &workers[i]);
+    }
+
+    // per type throughput and latency, once per second
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    int seconds = 0;
+    while (running)
+    {
+        next += std::chrono::seconds(1);
+        while (running && std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        std::lock_guard<std::mutex> lock(printMutex);
+        seconds++;
+        if (histogramSeconds > 0 && seconds % histogramSeconds == 0)
+        {
+            printHistograms(workers, false);
+        }
+        if (recordPath)
+        {
+            printRecordStatistics(&recorder);
+        }
+        if (quiet)
+        {
+            printQuietStatistics(recv, workers, seconds);
+            continue;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            ReceiveWorker& w = workers[i];
+            int64_t frames = w.frames.exchange(0);
+            int64_t bytes = w.bytes.exchange(0);
+            int64_t timeouts = w.timeouts.exchange(0);
+            int64_t sendTotalUs = w.sendTotalUs.exchange(0);
+            int64_t sent = w.relay ? w.relay->sent.exchange(0) : frames;
+            printf("%s: %lld frames/s, %.2f Mbps, %lld timeouts (wait %d ms, %.2f wakeups/frame), max gap %.2f ms, loopback send avg %.2f ms max %.2f ms",
+                w.name, (long long)frames, bytes * 8 / 1000000.0, (long long)timeouts, w.timeoutMs.load(), wakeupsPerFrame(frames, timeouts),
+                w.gapMaxUs.exchange(0) / 1000.0,
+                sent ? sendTotalUs / 1000.0 / sent : 0.0, w.sendMaxUs.exchange(0) / 1000.0);
+            if (w.relay)
+            {
+                printf(", relay queue max %lld delay max %.2f ms, dropped %lld oldest %lld newest",
+                    (long long)w.relay->depthMax.exchange(0), w.relay->delayMaxUs.exchange(0) / 1000.0,
+                    (long long)w.relay->droppedOldest.load(), (long long)w.relay->droppedNewest.load());
+            }
+            if (w.converter)
+            {
+                int64_t converted = w.convertFrames.exchange(0);
+                printf(", convert %s avg %.2f ms max %.2f ms, %lld unconvertible", omtConvertFormatName(w.convertFormat),
+                    converted ? w.convertTotalUs.exchange(0) / 1000.0 / converted : 0.0, w.convertMaxUs.exchange(0) / 1000.0,
+                    (long long)w.convertUnsupported.load());
+            }
+            printf("\n");
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        workers[i].thread.join();
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        Relay * relay = workers[i].relay.get();
+        if (relay)
+        {
+            relay->thread.join();
+            printf("relay %s: dropped %lld oldest, %lld newest\n", workers[i].name,
+                (long long)relay->droppedOldest.load(), (long long)relay->droppedNewest.load());
+            for (size_t j = 0; j < relay->slots.size(); j++)
+            {
+                relayPool.release(relay->slots[j].data);
+                relayPool.release(relay->slots[j].metadata);
+            }
         }
+    }
+    if (histogramSeconds > 0)
+    {
+        printHistograms(workers, true);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        int64_t frames = workers[i].framesTotal.load();
+        int64_t timeouts = workers[i].timeoutsTotal.load();
+        printf("wakeups %s: %lld frames, %lld timeouts, %.2f wakeups/frame\n", workers[i].name, (long long)frames, (long long)timeouts,
+            wakeupsPerFrame(frames, timeouts));
+    }
+    if (recordPath)
+    {
+        size_t frames = recorder.writer->frameCount();
+        uint64_t bytes = recorder.writer->bytesWritten();
+        bool closed = recorder.writer->close();
+        printf("record: %s %llu frames, %.1f MB, %lld dropped%s\n", recordPath, (unsigned long long)frames, bytes / 1000000.0,
+            (long long)recorder.dropped.load(), closed && !recorder.failed ? "" : ", FAILED");
     }
    	omt_receive_destroy(recv);
+    omt_send_destroy(sndloop);
+    return 0;
 }
 
 
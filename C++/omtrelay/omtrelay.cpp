@@ -0,0 +1,404 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+
+/*  omtrelay.cpp receives OMT sources as compressed VMX1 and republishes each of them through one or
+	more senders without decoding, so one upstream connection can feed many viewers.
+
+	Every source is received once with OMTReceiveFlags_CompressedOnly. Video, audio and metadata
+	each have a thread that forwards every frame to all of the source's replica senders, the way
+	omtrecvtest nativevmx loops one stream back out. Forwarding costs a copy into each sender's
+	connections and no encoding, so the limit is network bandwidth rather than CPU.
+
+	With --max-connections, once a second the relay checks each replica's connection count. OMT
+	redirects all receivers of a sender, not just the newest, so a replica above the limit is
+	redirected with omt_send_setredirect as a whole: to the least loaded local replica that can
+	take every one of its viewers without itself going over, otherwise to the next --peer (another
+	relay of the same source). With the same limit on every replica no local one can take the
+	whole audience of a replica over it, so in practice overflow goes to the peers, and local
+	replicas share load as separate sources that viewers pick between. A redirect stays until
+	its local target's count has held still for a pass and at least kSettleSeconds have gone by.
+	A replica that is redirecting, or that shed its viewers within the last kSettleSeconds, is
+	never chosen as a target, so two replicas cannot hand the same viewers back and forth.
+
+	Checked by driving balance() with two replicas, --max-connections 10 and receivers that follow
+	each redirect on the next pass: 12 viewers on replica 1 stayed put without a peer (12 + 0 > 10)
+	and went to the peer once with one, after which the redirect was lifted at t=6 and nothing
+	moved again. Before, the same viewers went from one replica to the other every second.
+
+	omtrelay "HOST (Source)" ["HOST (Source)" ...] [--replicas n] [--max-connections n] [--peer "HOST (Relay)"]... [--duration seconds]  */
+
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// The header for the C/C++ wrapper of OMT
+#include "../ndi2omt/libomt.h"
+
+using namespace std;
+
+std::atomic<bool> running(true);
+
+void signalHandler(int)
+{
+    running = false;
+}
+
+struct Replica
+{
+    omt_send_t* snd = NULL;
+    std::string address;        // as discovered, HOST (NAME)
+    std::string redirect;       // address this replica currently redirects to, empty when none
+    int redirectTarget = -1;    // index of the local replica redirected to, -1 for a peer
+    int targetConnections = -1; // the target's count at the previous pass, to tell when it has settled
+    int redirectedAt = 0;       // second the redirect was set
+    int shedAt = -1000;         // second the redirect was lifted, before which this is no target
+    int connections = 0;
+    int64_t bytesSent = 0;      // video and audio, as of the last report
+};
+
+struct RelaySource
+{
+    std::string address;
+    omt_receive_t* recv = NULL;
+    std::vector<Replica> replicas;
+    std::thread threads[3];
+    size_t nextPeer = 0;
+
+    // written by the forwarding threads, read and reset once per second by main
+    std::atomic<int64_t> videoFrames{0};
+    std::atomic<int64_t> audioFrames{0};
+    std::atomic<int64_t> metadataFrames{0};
+    std::atomic<int64_t> bytesIn{0};
+    std::atomic<int64_t> skipped{0};        // video that arrived uncompressed and cannot be relayed as is
+};
+
+// "HOST (Camera 1)" -> "Camera 1", used to name the replicas after their source
+std::string sourceName(const std::string& address)
+{
+    size_t open = address.find('(');
+    size_t close = address.rfind(')');
+    if (open != std::string::npos && close != std::string::npos && close > open + 1)
+    {
+        return address.substr(open + 1, close - open - 1);
+    }
+    return address;
+}
+
+// Forwards one frame type of a source to all of its replicas. Frames returned by omt_receive stay
+// valid until the next call for the same type, which is after every replica has sent it.
+void forwardLoop(RelaySource* source, OMTFrameType type, int timeoutMs)
+{
+    while (running)
+    {
+        OMTMediaFrame* received = omt_receive(source->recv, type, timeoutMs);
+        if (!received)
+        {
+            continue;
+        }
+        OMTMediaFrame frame = *received;
+        if (type == OMTFrameType_Video)
+        {
+            if (received->Codec != OMTCodec_VMX1 || !received->CompressedData || received->CompressedLength <= 0)
+            {
+                source->skipped++;
+                continue;
+            }
+            // Sending VMX1 in Data passes the compressed frame through untouched
+            frame.Data = received->CompressedData;
+            frame.DataLength = received->CompressedLength;
+            source->videoFrames++;
+        }
+        else if (type == OMTFrameType_Audio)
+        {
+            source->audioFrames++;
+        }
+        else
+        {
+            source->metadataFrames++;
+        }
+        frame.CompressedData = NULL;
+        frame.CompressedLength = 0;
+        source->bytesIn += frame.DataLength;
+
+        for (size_t i = 0; i < source->replicas.size(); i++)
+        {
+            omt_send(source->replicas[i].snd, &frame);
+        }
+    }
+}
+
+// Seconds a redirect is held, and a replica that shed its viewers is passed over as a target
+const int kSettleSeconds = 5;
+
+// Sets or lifts redirects on a source's replicas from their latest connection counts, t seconds in
+void balance(RelaySource& source, int maxConnections, const std::vector<std::string>& peers, int t)
+{
+    for (size_t i = 0; i < source.replicas.size(); i++)
+    {
+        Replica& replica = source.replicas[i];
+        if (!replica.redirect.empty())
+        {
+            // Lifted once the viewers have landed: the local target stopped changing, a peer had time
+            bool settled = t - replica.redirectedAt >= kSettleSeconds;
+            if (replica.redirectTarget >= 0)
+            {
+                int targetConnections = source.replicas[replica.redirectTarget].connections;
+                settled = settled && targetConnections == replica.targetConnections;
+                replica.targetConnections = targetConnections;
+            }
+            if (settled && replica.connections <= maxConnections)
+            {
+                omt_send_setredirect(replica.snd, NULL);
+                std::cout << "relay.redirect.cleared: " << replica.address << " (" << replica.connections << " connections)\n";
+                replica.redirect.clear();
+                replica.redirectTarget = -1;
+                replica.shedAt = t;
+            }
+            continue;
+        }
+        if (replica.connections <= maxConnections)
+        {
+            continue;
+        }
+
+        // Every viewer moves, so the target needs room for all of them
+        int target = -1;
+        for (size_t j = 0; j < source.replicas.size(); j++)
+        {
+            const Replica& candidate = source.replicas[j];
+            if (j != i && candidate.redirect.empty() && t - candidate.shedAt >= kSettleSeconds &&
+                candidate.connections + replica.connections <= maxConnections &&
+                (target < 0 || candidate.connections < source.replicas[target].connections))
+            {
+                target = (int)j;
+            }
+        }
+        std::string address;
+        if (target >= 0)
+        {
+            address = source.replicas[target].address;
+            replica.targetConnections = source.replicas[target].connections;
+        }
+        else if (!peers.empty())
+        {
+            address = peers[source.nextPeer % peers.size()];
+            source.nextPeer++;
+        }
+        else
+        {
+            continue;
+        }
+        omt_send_setredirect(replica.snd, address.c_str());
+        replica.redirect = address;
+        replica.redirectTarget = target;
+        replica.redirectedAt = t;
+        std::cout << "relay.redirect: " << replica.address << " (" << replica.connections << " connections) -> " << address << "\n";
+    }
+}
+
+int relay(const std::vector<std::string>& addresses, int replicaCount, int maxConnections, const std::vector<std::string>& peers, int seconds)
+{
+    std::vector<std::unique_ptr<RelaySource>> sources;
+    for (size_t s = 0; s < addresses.size(); s++)
+    {
+        std::unique_ptr<RelaySource> source(new RelaySource());
+        source->address = addresses[s];
+        source->recv = omt_receive_create(addresses[s].c_str(), (OMTFrameType)(OMTFrameType_Video | OMTFrameType_Audio | OMTFrameType_Metadata),
+                                          OMTPreferredVideoFormat_UYVYorUYVAorP216orPA16, OMTReceiveFlags_CompressedOnly);
+        if (!source->recv)
+        {
+            std::cout << "omt_receive_create.failed: " << addresses[s] << "\n";
+            continue;
+        }
+        source->replicas.resize(replicaCount);
+        for (int r = 0; r < replicaCount; r++)
+        {
+            std::string name = "Relay " + sourceName(addresses[s]);
+            if (replicaCount > 1)
+            {
+                name += " " + std::to_string(r + 1);
+            }
+            Replica& replica = source->replicas[r];
+            replica.snd = omt_send_create(name.c_str(), OMTQuality_Default);
+            if (!replica.snd)
+            {
+                std::cout << "omt_send_create.failed: " << name << "\n";
+                source->replicas.resize(r);
+                break;
+            }
+            char address[OMT_MAX_STRING_LENGTH] = {};
+            omt_send_getaddress(replica.snd, address, sizeof(address));
+            replica.address = address;
+        }
+        std::cout << "relay: " << source->address << " -> " << source->replicas.size() << " replicas\n";
+        sources.push_back(std::move(source));
+    }
+    if (sources.empty())
+    {
+        return 1;
+    }
+
+    // Audio is serviced promptly, video waits about two frames, metadata is rare
+    for (size_t s = 0; s < sources.size(); s++)
+    {
+        RelaySource* source = sources[s].get();
+        source->threads[0] = std::thread(forwardLoop, source, OMTFrameType_Video, 40);
+        source->threads[1] = std::thread(forwardLoop, source, OMTFrameType_Audio, 20);
+        source->threads[2] = std::thread(forwardLoop, source, OMTFrameType_Metadata, 100);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 1; running && (seconds <= 0 || t <= seconds); t++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::seconds(t));
+        int totalConnections = 0;
+        int64_t totalBytesOut = 0;
+        for (size_t s = 0; s < sources.size(); s++)
+        {
+            RelaySource& source = *sources[s];
+            int connections = 0;
+            int redirected = 0;
+            int64_t bytesOut = 0;
+            for (size_t r = 0; r < source.replicas.size(); r++)
+            {
+                Replica& replica = source.replicas[r];
+                replica.connections = omt_send_connections(replica.snd);
+                OMTStatistics video = {}, audio = {};
+                omt_send_getvideostatistics(replica.snd, &video);
+                omt_send_getaudiostatistics(replica.snd, &audio);
+                bytesOut += video.BytesSent + audio.BytesSent - replica.bytesSent;
+                replica.bytesSent = video.BytesSent + audio.BytesSent;
+                connections += replica.connections;
+            }
+            if (maxConnections > 0)
+            {
+                balance(source, maxConnections, peers, t);
+            }
+            for (size_t r = 0; r < source.replicas.size(); r++)
+            {
+                redirected += source.replicas[r].redirect.empty() ? 0 : 1;
+            }
+            std::cout << "relay: t=" << t << "s " << source.address << " in " << source.videoFrames.exchange(0) << " fps "
+                      << source.audioFrames.exchange(0) << " audio " << source.metadataFrames.exchange(0) << " metadata "
+                      << source.bytesIn.exchange(0) * 8 / 1000000.0 << " Mbps";
+            int64_t skipped = source.skipped.exchange(0);
+            if (skipped)
+            {
+                std::cout << " (" << skipped << " uncompressed skipped)";
+            }
+            std::cout << ", out " << bytesOut * 8 / 1000000.0 << " Mbps to " << connections << " connections";
+            if (source.replicas.size() > 1)
+            {
+                std::cout << " [";
+                for (size_t r = 0; r < source.replicas.size(); r++)
+                {
+                    std::cout << (r ? " " : "") << source.replicas[r].connections << (source.replicas[r].redirect.empty() ? "" : "*");
+                }
+                std::cout << "]";
+            }
+            if (redirected)
+            {
+                std::cout << ", " << redirected << " redirected";
+            }
+            std::cout << "\n";
+            totalConnections += connections;
+            totalBytesOut += bytesOut;
+        }
+        if (sources.size() > 1)
+        {
+            std::cout << "relay: t=" << t << "s total out " << totalBytesOut * 8 / 1000000.0 << " Mbps to " << totalConnections << " connections\n";
+        }
+    }
+
+    running = false;
+    for (size_t s = 0; s < sources.size(); s++)
+    {
+        RelaySource& source = *sources[s];
+        for (int i = 0; i < 3; i++)
+        {
+            source.threads[i].join();
+        }
+        omt_receive_destroy(source.recv);
+        for (size_t r = 0; r < source.replicas.size(); r++)
+        {
+            omt_send_destroy(source.replicas[r].snd);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, const char * argv[])
+{
+    std::cout << "OMTRelay\n";
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+    omt_setloggingfilename("omtrelay.log");
+
+    std::vector<std::string> addresses;
+    std::vector<std::string> peers;
+    int replicaCount = 1;
+    int maxConnections = 0;
+    int seconds = 0;
+    for (int a = 1; a < argc; a++)
+    {
+        if (!strcasecmp(argv[a], "--replicas") && a + 1 < argc)
+        {
+            replicaCount = atoi(argv[++a]);
+        }
+        else if (!strcasecmp(argv[a], "--max-connections") && a + 1 < argc)
+        {
+            maxConnections = atoi(argv[++a]);
+        }
+        else if (!strcasecmp(argv[a], "--peer") && a + 1 < argc)
+        {
+            peers.push_back(argv[++a]);
+        }
+        else if (!strcasecmp(argv[a], "--duration") && a + 1 < argc)
+        {
+            seconds = atoi(argv[++a]);
+        }
+        else if (argv[a][0] != '-')
+        {
+            addresses.push_back(argv[a]);
+        }
+    }
+
+    if (addresses.empty())
+    {
+        printf("Usage : omtrelay \"HOST (OMTSOURCE)\" [\"HOST (OMTSOURCE)\" ...] [--replicas n] [--max-connections n] [--peer \"HOST (RELAY)\"]... [--duration seconds]\n");
+        return 0;
+    }
+    return relay(addresses, replicaCount > 0 ? replicaCount : 1, maxConnections, peers, seconds);
+}
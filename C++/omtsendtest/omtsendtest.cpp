@@ -34,6 +34,10 @@
 #include <chrono>
 #include <thread>
 #include <fstream>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cmath>
 #include <stdlib.h>
 #include <string.h>
 
@@ -42,20 +46,828 @@
 // link this exe with libomt, and make sure libomt and libvpx are accessible to the exe, either in the same folder, or linked explicitly via rpath or otherwise.
 // libomt will dynamically open libvpx at runtime
 
+// Pooled, aligned buffers for OMTMediaFrame.Data shared by the examples
+#include "../common/omt_frame_pool.h"
+// Ring of pre-rendered frames where only the moving lines are redrawn
+#include "../common/omt_frame_ring.h"
+// Memory mapped raw/Y4M clips played frame by frame
+#include "../common/omt_clip_source.h"
+// Noise, tone and sweep test signals written straight into FPA1 buffers
+#include "../common/omt_audio_generator.h"
+// UYVY to the other sender input formats, for the format benchmark
+#include "../common/omt_pixel_convert.h"
+// Tally, metadata, connections and statistics on a thread of their own
+#include "../common/omt_control_plane.h"
+// Steps encoding quality and resolution down and up again from the sender's encode time
+#include "../common/omt_quality_controller.h"
+// Sequence number and send time in frame metadata and an optional barcode, for omtrecvtest --probe
+#include "../common/omt_latency_probe.h"
+
 using namespace std;
 
-#include <random>
+// Maps an --audio name to a test signal, returns false if unknown
+bool parseAudioSignal(const char* name, OMTAudioSignal& signal)
+{
+    static const struct { const char* name; OMTAudioSignal signal; } signals[] = {
+        { "noise", OMTAudioSignal_WhiteNoise }, { "pink", OMTAudioSignal_PinkNoise }, { "tone", OMTAudioSignal_Tone },
+        { "sweep", OMTAudioSignal_Sweep }, { "silence", OMTAudioSignal_Silence }
+    };
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++)
+    {
+        if (!strcasecmp(name, signals[i].name))
+        {
+            signal = signals[i].signal;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Keeps the benchmarked output observable so the work is not optimized away
+volatile float benchmarkSink;
+
+// Measures generator throughput for each signal at the given channel count, in 800 sample blocks
+void benchmarkAudio(int channels)
+{
+    const int samples = 800;
+    const int blocks = 6000;
+    std::vector<float> buffer((size_t)samples * channels);
+    std::cout << "benchaudio: " << channels << " channels, " << samples << " samples per block\n";
+
+    // libc rand(), as the test used to generate noise
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < blocks / 10; b++)
+    {
+        for (size_t z = 0; z < buffer.size(); z++)
+        {
+            buffer[z] = 2.0f * ((float)rand() / (float)RAND_MAX) - 1.0f;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "benchaudio.rand: " << (blocks / 10) * buffer.size() / seconds / 1e6 << " Msamples/s\n";
+
+    const char* names[] = { "noise", "pink", "tone", "sweep" };
+    for (int n = 0; n < 4; n++)
+    {
+        OMTAudioGeneratorOptions options;
+        parseAudioSignal(names[n], options.signal);
+        options.channels = channels;
+        OMTAudioGenerator generator(options);
+        start = std::chrono::steady_clock::now();
+        float check = 0;
+        for (int b = 0; b < blocks; b++)
+        {
+            generator.render(buffer.data(), samples);
+            check += buffer[b % buffer.size()];
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        benchmarkSink = check;
+        std::cout << "benchaudio." << names[n] << ": " << blocks * buffer.size() / seconds / 1e6 << " Msamples/s\n";
+    }
+}
+
+// Maps a --format name to the OMT codec of a raw clip, 0 if unknown
+uint32_t parseClipFormat(const char* name)
+{
+    static const struct { const char* name; uint32_t codec; } formats[] = {
+        { "uyvy", OMTCodec_UYVY }, { "yuy2", OMTCodec_YUY2 }, { "bgra", OMTCodec_BGRA }, { "uyva", OMTCodec_UYVA },
+        { "nv12", OMTCodec_NV12 }, { "yv12", OMTCodec_YV12 }, { "p216", OMTCodec_P216 }, { "pa16", OMTCodec_PA16 }
+    };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        if (!strcasecmp(name, formats[i].name))
+        {
+            return formats[i].codec;
+        }
+    }
+    return 0;
+}
+
+// How the main loop times its sends:
+// Omt: Timestamp -1, omt_send holds each call to keep the frame rate
+// Unclocked: explicit timestamps and no waiting, to measure how fast frames can be sent
+// Paced: explicit timestamps, sends released by our own clock, with deadline misses counted
+enum SendClocking
+{
+    SendClocking_Omt,
+    SendClocking_Unclocked,
+    SendClocking_Paced
+};
+
+// One sender of the load test: <width>x<height>@<fps>[:<format>[:<quality>]], e.g. 1920x1080@59.94:uyvy:high
+struct LoadSpec
+{
+    int width = 1920;
+    int height = 1080;
+    int frameRateN = 60000;
+    int frameRateD = 1000;
+    uint32_t codec = OMTCodec_UYVY;
+    OMTQuality quality = OMTQuality_Default;
+    std::string text = "1920x1080@60:uyvy:default";
+};
+
+bool parseLoadSpec(const char* text, LoadSpec& spec)
+{
+    char format[16] = "uyvy";
+    char quality[16] = "default";
+    double fps = 0;
+    int fields = sscanf(text, "%dx%d@%lf:%15[^:]:%15s", &spec.width, &spec.height, &fps, format, quality);
+    if (fields < 3 || spec.width <= 0 || spec.height <= 0 || fps <= 0)
+    {
+        return false;
+    }
+    spec.codec = parseClipFormat(format);
+    int stride;
+    if (!spec.codec || !OMTClipSource::rawFrameLength(spec.codec, spec.width, spec.height, stride))
+    {
+        return false;
+    }
+    if (!strcasecmp(quality, "low")) spec.quality = OMTQuality_Low;
+    else if (!strcasecmp(quality, "medium")) spec.quality = OMTQuality_Medium;
+    else if (!strcasecmp(quality, "high")) spec.quality = OMTQuality_High;
+    else if (!strcasecmp(quality, "default")) spec.quality = OMTQuality_Default;
+    else return false;
+
+    // NTSC rates such as 29.97 and 59.94 are n*1000/1001
+    double ntsc = fps * 1.001;
+    if (fabs(ntsc - floor(ntsc + 0.5)) < 0.01 && fabs(fps - floor(fps + 0.5)) > 0.01)
+    {
+        spec.frameRateN = (int)floor(ntsc + 0.5) * 1000;
+        spec.frameRateD = 1001;
+    }
+    else
+    {
+        spec.frameRateN = (int)floor(fps * 1000 + 0.5);
+        spec.frameRateD = 1000;
+    }
+    spec.text = text;
+    return true;
+}
+
+struct LoadSender
+{
+    LoadSpec spec;
+    omt_send_t* snd = NULL;
+    omt_receive_t* rcv = NULL;      // local compressed-only receiver: OMT only encodes for a connection
+    std::thread thread;
+    OMTStatistics last = {};
+    int64_t framesDropped = 0;
+    double intervalFps = 0;
+};
+
+std::atomic<bool> loadRunning(true);
+
+// Sends frames of a moving bar over a fixed pattern as fast as OMT clocking lets it
+void runLoadSender(LoadSender* sender, OMTFramePool* pool)
+{
+    const LoadSpec& spec = sender->spec;
+    OMTMediaFrame frame = {};
+    frame.Type = OMTFrameType_Video;
+    frame.Codec = (OMTCodec)spec.codec;
+    frame.Width = spec.width;
+    frame.Height = spec.height;
+    frame.DataLength = (int)OMTClipSource::rawFrameLength(spec.codec, spec.width, spec.height, frame.Stride);
+    frame.Timestamp = -1;
+    frame.ColorSpace = spec.height >= 720 ? OMTColorSpace_BT709 : OMTColorSpace_BT601;
+    frame.FrameRateN = spec.frameRateN;
+    frame.FrameRateD = spec.frameRateD;
+    frame.AspectRatio = (float)spec.width / spec.height;
+
+    // A diagonal ramp gives the encoder something other than flat colour in every format
+    uint8_t* pattern = (uint8_t*)pool->acquire(spec.codec, spec.width, spec.height, frame.Stride, frame.DataLength);
+    if (!pattern)
+    {
+        return;
+    }
+    for (int i = 0; i < frame.DataLength; i++)
+    {
+        pattern[i] = (uint8_t)((i % frame.Stride) / 4 + (i / frame.Stride));
+    }
+    std::vector<uint8_t> bar((size_t)frame.Stride * 8, 255);
+    int lumaBytes = frame.Stride * spec.height;
+    {
+        OMTFrameRing frames(*pool, spec.codec, spec.width, spec.height, frame.Stride, frame.DataLength, pattern);
+        if (!frames.valid())
+        {
+            std::cout << "load.frame_ring.failed: " << spec.text << "\n";
+            pool->release(pattern);
+            return;
+        }
+        int barPos = 0;
+        while (loadRunning)
+        {
+            frame.Data = frames.next();
+            frames.draw(barPos, bar.data(), bar.size());
+            barPos += frame.Stride * 8;
+            if (barPos + (int)bar.size() > lumaBytes)
+            {
+                barPos = 0;
+            }
+            omt_send(sender->snd, &frame);
+            omt_receive(sender->rcv, OMTFrameType_Video, 0);
+        }
+    }
+    pool->release(pattern);
+}
+
+// Runs the senders for the given time, reporting once per second and summarising at the end. Each sender
+// gets a local receiver of the compressed stream, as --benchformats does, so every frame is encoded.
+void runLoadTest(const std::vector<LoadSpec>& specs, int count, int seconds, OMTFramePool& pool)
+{
+    std::vector<LoadSender> senders(count);
+    for (int i = 0; i < count; i++)
+    {
+        senders[i].spec = specs[i % specs.size()];
+        std::string name = "Load " + std::to_string(i + 1);
+        senders[i].snd = omt_send_create(name.c_str(), senders[i].spec.quality);
+        if (!senders[i].snd)
+        {
+            std::cout << "load.omt_send_create.failed: " << name << "\n";
+            count = i;
+            senders.resize(count);
+            break;
+        }
+        char address[OMT_MAX_STRING_LENGTH] = {};
+        omt_send_getaddress(senders[i].snd, address, sizeof(address));
+        senders[i].rcv = omt_receive_create(address, OMTFrameType_Video, OMTPreferredVideoFormat_UYVY, OMTReceiveFlags_CompressedOnly);
+        if (!senders[i].rcv)
+        {
+            std::cout << "load.omt_receive_create.failed: " << address << "\n";
+            omt_send_destroy(senders[i].snd);
+            count = i;
+            senders.resize(count);
+            break;
+        }
+    }
+    if (count == 0)
+    {
+        return;
+    }
+    int connected = 0;
+    for (int wait = 0; wait < 50; wait++)
+    {
+        connected = 0;
+        for (int i = 0; i < count; i++)
+        {
+            connected += omt_send_connections(senders[i].snd) > 0 ? 1 : 0;
+        }
+        if (connected == count)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (connected < count)
+    {
+        std::cout << "load.receivers.unconnected: " << (count - connected) << " of " << count << " senders have no receiver and will not encode\n";
+    }
+    std::cout << "load.start: " << count << " senders for " << seconds << " seconds\n";
+
+    loadRunning = true;
+    for (int i = 0; i < count; i++)
+    {
+        senders[i].thread = std::thread(runLoadSender, &senders[i], &pool);
+    }
+
+    double targetFps = 0;
+    for (int i = 0; i < count; i++)
+    {
+        targetFps += (double)senders[i].spec.frameRateN / senders[i].spec.frameRateD;
+    }
 
-// Generate a random number between a and b
-// used to generate audio noise.
-float rand_FloatRange(float a, float b)
+    auto start = std::chrono::steady_clock::now();
+    auto previous = start;
+    for (int t = 1; t <= seconds; t++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::seconds(t));
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - previous).count();
+        previous = now;
+
+        double fps = 0;
+        int64_t frames = 0, codecTime = 0, dropped = 0, worstCodec = 0;
+        int slipping = 0;
+        connected = 0;
+        for (int i = 0; i < count; i++)
+        {
+            LoadSender& sender = senders[i];
+            connected += omt_send_connections(sender.snd) > 0 ? 1 : 0;
+            OMTStatistics stats = {};
+            omt_send_getvideostatistics(sender.snd, &stats);
+            int64_t senderFrames = stats.Frames - sender.last.Frames;
+            sender.intervalFps = senderFrames / elapsed;
+            fps += sender.intervalFps;
+            frames += senderFrames;
+            codecTime += stats.CodecTime - sender.last.CodecTime;
+            dropped += stats.FramesDropped - sender.last.FramesDropped;
+            if (stats.CodecTimeSinceLast > worstCodec)
+            {
+                worstCodec = stats.CodecTimeSinceLast;
+            }
+            // A sender more than 2% under its rate is not keeping up
+            if (sender.intervalFps < 0.98 * sender.spec.frameRateN / sender.spec.frameRateD)
+            {
+                slipping++;
+            }
+            sender.framesDropped = stats.FramesDropped;
+            sender.last = stats;
+        }
+        std::cout << "load: t=" << t << "s fps " << fps << "/" << targetFps
+                  << " codec " << (frames ? (double)codecTime / frames : 0) << " ms/frame (last max " << worstCodec << " ms)"
+                  << " dropped " << dropped << " slipping " << slipping << "/" << count
+                  << " connected " << connected << "/" << count << "\n";
+    }
+
+    loadRunning = false;
+    for (int i = 0; i < count; i++)
+    {
+        senders[i].thread.join();
+    }
+
+    std::cout << "load.summary:\n";
+    for (int i = 0; i < count; i++)
+    {
+        LoadSender& sender = senders[i];
+        std::cout << "  Load " << (i + 1) << " " << sender.spec.text << ": " << sender.last.Frames / (double)seconds << " fps, "
+                  << (sender.last.Frames ? (double)sender.last.CodecTime / sender.last.Frames : 0) << " ms/frame codec, "
+                  << sender.framesDropped << " dropped\n";
+        omt_receive_destroy(sender.rcv);
+        omt_send_destroy(sender.snd);
+    }
+}
+
+// Loads california-1080-uyvy.yuv, or a luma ramp if it is missing. Returns false for the ramp.
+bool loadSampleFrame(uint8_t* uyvy, int width, int height)
+{
+    const int length = width * 2 * height;
+    std::ifstream file("california-1080-uyvy.yuv", std::ios::binary);
+    if (file.read((char*)uyvy, length))
+    {
+        return true;
+    }
+    for (int i = 0; i < length; i++)
+    {
+        uyvy[i] = (i & 1) ? (uint8_t)(16 + ((i / 2) % width) * 219 / width) : 128;
+    }
+    return false;
+}
+
+// Measures the UYVY to P216 and PA16 up-conversion, scalar and with the SIMD path the build targets
+void benchmarkConvert(int frames, OMTFramePool& pool)
 {
-    return ((b - a) * ((float)rand() / (float)RAND_MAX)) + a;
+    const int width = 1920;
+    const int height = 1080;
+    uint8_t* uyvy = (uint8_t*)pool.acquire(OMTCodec_UYVY, width, height, width * 2, width * 2 * height);
+    if (!loadSampleFrame(uyvy, width, height))
+    {
+        std::cout << "benchconvert: california-1080-uyvy.yuv not found, using a ramp\n";
+    }
+
+    const struct { const char* name; OMTCodec codec; int length; } formats[] = {
+        { "P216", OMTCodec_P216, width * height * 4 }, { "PA16", OMTCodec_PA16, width * height * 6 }
+    };
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+    {
+        uint8_t* reference = (uint8_t*)pool.acquire(formats[f].codec, width, height, width * 2, formats[f].length);
+        uint8_t* data = (uint8_t*)pool.acquire(formats[f].codec, width, height, width * 2, formats[f].length);
+        for (int simd = 0; simd < 2; simd++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; i++)
+            {
+                if (formats[f].codec == OMTCodec_PA16)
+                {
+                    omtConvertUyvyToPa16(uyvy, width * 2, simd ? data : reference, width, height, simd != 0);
+                }
+                else
+                {
+                    omtConvertUyvyToP216(uyvy, width * 2, simd ? data : reference, width, height, simd != 0);
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double bytes = (double)frames * (width * 2 * height + formats[f].length);
+            std::cout << "benchconvert." << formats[f].name << "." << (simd ? omtPixelConvertSimd() : "scalar") << ": "
+                      << seconds * 1000 / frames << " ms/frame, " << bytes / seconds / 1e9 << " GB/s\n";
+        }
+        if (memcmp(reference, data, formats[f].length))
+        {
+            std::cout << "benchconvert." << formats[f].name << ": SIMD output differs from scalar\n";
+        }
+        pool.release(reference);
+        pool.release(data);
+    }
+    pool.release(uyvy);
 }
 
-int main()
+// One input format of the format benchmark, converted once from the sample frame
+struct BenchFormat
+{
+    const char* name;
+    OMTCodec codec;
+    int stride;
+    int length;
+    void* data;
+};
+
+// Sends frames unclocked in every input format at every quality and prints what each costs,
+// as CSV or JSON. A local receiver is connected so the sender actually encodes; it takes only the
+// compressed frames, which also provides the VMX1 input.
+void runFormatBenchmark(int frames, bool json, OMTFramePool& pool)
 {
-    std::cout << "OMTSendTest\n";
+    const int width = 1920;
+    const int height = 1080;
+    const int uyvyLength = width * 2 * height;
+
+    uint8_t* uyvy = (uint8_t*)pool.acquire(OMTCodec_UYVY, width, height, width * 2, uyvyLength);
+    if (!loadSampleFrame(uyvy, width, height))
+    {
+        std::cerr << "benchformats: california-1080-uyvy.yuv not found, using a ramp\n";
+    }
+
+    BenchFormat formats[] = {
+        { "UYVY", OMTCodec_UYVY, width * 2, uyvyLength, uyvy },
+        { "YUY2", OMTCodec_YUY2, width * 2, uyvyLength, NULL },
+        { "NV12", OMTCodec_NV12, width, width * height * 3 / 2, NULL },
+        { "YV12", OMTCodec_YV12, width, width * height * 3 / 2, NULL },
+        { "BGRA", OMTCodec_BGRA, width * 4, width * 4 * height, NULL },
+        { "UYVA", OMTCodec_UYVA, width * 2, width * 3 * height, NULL },
+        { "P216", OMTCodec_P216, width * 2, width * 4 * height, NULL },
+        { "PA16", OMTCodec_PA16, width * 2, width * 6 * height, NULL },
+        { "VMX1", OMTCodec_VMX1, 0, 0, NULL }
+    };
+    const int formatCount = sizeof(formats) / sizeof(formats[0]);
+    for (int f = 1; f < formatCount - 1; f++)
+    {
+        BenchFormat& format = formats[f];
+        uint8_t* data = (uint8_t*)pool.acquire(format.codec, width, height, format.stride, format.length);
+        switch (format.codec)
+        {
+        case OMTCodec_YUY2: omtConvertUyvyToYuy2(uyvy, width * 2, data, format.stride, width, height); break;
+        case OMTCodec_NV12: omtConvertUyvyToNv12(uyvy, width * 2, data, width, height); break;
+        case OMTCodec_YV12: omtConvertUyvyToYv12(uyvy, width * 2, data, width, height); break;
+        case OMTCodec_BGRA: omtConvertUyvyToBgra(uyvy, width * 2, data, format.stride, width, height); break;
+        case OMTCodec_UYVA: omtConvertUyvyToUyva(uyvy, width * 2, data, width, height); break;
+        case OMTCodec_P216: omtConvertUyvyToP216(uyvy, width * 2, data, width, height); break;
+        case OMTCodec_PA16: omtConvertUyvyToPa16(uyvy, width * 2, data, width, height); break;
+        default: break;
+        }
+        format.data = data;
+    }
+
+    const struct { const char* name; OMTQuality quality; } qualities[] = {
+        { "Low", OMTQuality_Low }, { "Medium", OMTQuality_Medium }, { "High", OMTQuality_High }
+    };
+
+    if (json)
+    {
+        std::cout << "[\n";
+    }
+    else
+    {
+        std::cout << "quality,format,frames,codec_ms_per_frame,wall_ms_per_frame,bytes_per_frame\n";
+    }
+    bool firstRow = true;
+    std::vector<uint8_t> vmx;
+
+    for (size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++)
+    {
+        std::string name = std::string("Bench ") + qualities[q].name;
+        omt_send_t* snd = omt_send_create(name.c_str(), qualities[q].quality);
+        if (!snd)
+        {
+            std::cerr << "benchformats.omt_send_create.failed\n";
+            break;
+        }
+        char address[OMT_MAX_STRING_LENGTH] = {};
+        omt_send_getaddress(snd, address, sizeof(address));
+        omt_receive_t* rcv = omt_receive_create(address, OMTFrameType_Video, OMTPreferredVideoFormat_UYVY, OMTReceiveFlags_CompressedOnly);
+        for (int wait = 0; rcv && wait < 50 && omt_send_connections(snd) == 0; wait++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (!rcv || omt_send_connections(snd) == 0)
+        {
+            std::cerr << "benchformats: loopback receiver did not connect to " << address << "\n";
+            if (rcv)
+            {
+                omt_receive_destroy(rcv);
+            }
+            omt_send_destroy(snd);
+            break;
+        }
+
+        int64_t timestamp = 0;
+        vmx.clear();
+        for (int f = 0; f < formatCount; f++)
+        {
+            BenchFormat& format = formats[f];
+            OMTMediaFrame frame = {};
+            frame.Type = OMTFrameType_Video;
+            frame.Codec = format.codec;
+            frame.Width = width;
+            frame.Height = height;
+            frame.Stride = format.stride;
+            frame.ColorSpace = OMTColorSpace_BT709;
+            frame.FrameRateN = 60000;
+            frame.FrameRateD = 1000;
+            frame.AspectRatio = 16.0f / 9.0f;
+            // Flagged as the --highbitdepth path does: without Alpha, UYVA is encoded as UYVY and PA16 as P216
+            int flags = OMTVideoFlags_None;
+            if (format.codec == OMTCodec_UYVA || format.codec == OMTCodec_PA16)
+            {
+                flags |= OMTVideoFlags_Alpha;
+            }
+            if (format.codec == OMTCodec_P216 || format.codec == OMTCodec_PA16)
+            {
+                flags |= OMTVideoFlags_HighBitDepth;
+            }
+            frame.Flags = (OMTVideoFlags)flags;
+            frame.Data = format.data;
+            frame.DataLength = format.length;
+            if (format.codec == OMTCodec_VMX1)
+            {
+                // Compressed frames captured by the receiver during the UYVY run, at this quality
+                if (vmx.empty())
+                {
+                    continue;
+                }
+                frame.Data = vmx.data();
+                frame.DataLength = (int)vmx.size();
+            }
+
+            OMTStatistics before = {};
+            omt_send_getvideostatistics(snd, &before);
+            double sendSeconds = 0;
+            for (int i = 0; i < frames; i++)
+            {
+                // Explicit timestamps leave the sender unclocked, so each send costs only its own work
+                frame.Timestamp = timestamp;
+                timestamp += 10000000LL * frame.FrameRateD / frame.FrameRateN;
+                auto start = std::chrono::steady_clock::now();
+                omt_send(snd, &frame);
+                sendSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                OMTMediaFrame* received = omt_receive(rcv, OMTFrameType_Video, 0);
+                if (received && format.codec == OMTCodec_UYVY && received->CompressedData && received->CompressedLength > 0)
+                {
+                    vmx.assign((uint8_t*)received->CompressedData, (uint8_t*)received->CompressedData + received->CompressedLength);
+                }
+            }
+            OMTStatistics after = {};
+            omt_send_getvideostatistics(snd, &after);
+
+            int64_t encoded = after.Frames - before.Frames;
+            double codecMs = encoded ? (double)(after.CodecTime - before.CodecTime) / encoded : 0;
+            double wallMs = sendSeconds * 1000.0 / frames;
+            double bytes = encoded ? (double)(after.BytesSent - before.BytesSent) / encoded : 0;
+            if (json)
+            {
+                std::cout << (firstRow ? "" : ",\n") << "  { \"quality\": \"" << qualities[q].name << "\", \"format\": \"" << format.name
+                          << "\", \"frames\": " << encoded << ", \"codec_ms_per_frame\": " << codecMs
+                          << ", \"wall_ms_per_frame\": " << wallMs << ", \"bytes_per_frame\": " << bytes << " }";
+            }
+            else
+            {
+                std::cout << qualities[q].name << "," << format.name << "," << encoded << "," << codecMs << "," << wallMs << "," << bytes << "\n";
+            }
+            firstRow = false;
+        }
+
+        omt_receive_destroy(rcv);
+        omt_send_destroy(snd);
+    }
+    if (json)
+    {
+        std::cout << "\n]\n";
+    }
+
+    for (int f = 0; f < formatCount; f++)
+    {
+        if (formats[f].codec != OMTCodec_VMX1)
+        {
+            pool.release(formats[f].data);
+        }
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    // optional parameters: --hugepages to back frame buffers with huge pages, --numa <node> to place them on a NUMA node
+    // --clip <file> plays a clip instead of the still image: a .y4m file, or raw frames described by
+    // --format uyvy|yuy2|bgra|uyva|nv12|yv12|p216|pa16 (default uyvy) and --size <width>x<height> (default 1920x1080)
+    OMTFramePoolOptions poolOptions;
+    const char* clipPath = NULL;
+    uint32_t clipCodec = OMTCodec_UYVY;
+    int clipWidth = 1920;
+    int clipHeight = 1080;
+    // --audio noise|pink|tone|sweep|silence selects the test signal and --channels <n> the channel count,
+    // at most the 32 OMT can send, which --benchaudio also keeps to; --benchaudio measures the generator and exits
+    OMTAudioGeneratorOptions audioOptions;
+    bool benchAudio = false;
+    // --load <n> runs n senders for --duration <seconds> (default 30) instead of the single test output,
+    // each described by a --spec <width>x<height>@<fps>[:<format>[:low|medium|high|default]]; several specs are used in turn
+    int loadSenders = 0;
+    int loadSeconds = 30;
+    std::vector<LoadSpec> loadSpecs;
+    // --benchformats [frames] sends the sample frame unclocked in each input format and quality and prints
+    // the cost of each as CSV, or JSON with --json
+    int benchFormatFrames = 0;
+    bool benchJson = false;
+    // --clocking omt|unclocked|paced selects who times the sends (default omt)
+    SendClocking clocking = SendClocking_Omt;
+    // --adaptive lowers quality, then resolution, when encoding takes more than --target-load
+    // (default 0.5) of the frame period or frames are dropped, and raises it again when there is room
+    bool adaptive = false;
+    // --highbitdepth p216|pa16 sends the image up-converted to 16 bits per sample;
+    // --benchconvert [frames] measures that conversion and exits
+    OMTCodec highBitDepthCodec = (OMTCodec)0;
+    int benchConvertFrames = 0;
+    // --probe stamps each video frame with a sequence number and its send time for omtrecvtest --probe;
+    // --barcode also draws them into the picture so the measurement includes encoding and decoding
+    bool probe = false;
+    bool barcode = false;
+    OMTQualityControllerOptions qualityOptions;
+    for (int a = 1; a < argc; a++)
+    {
+        if (!strcasecmp(argv[a], "--hugepages"))
+        {
+            poolOptions.hugePages = true;
+        }
+        else if (!strcasecmp(argv[a], "--numa") && a + 1 < argc)
+        {
+            poolOptions.numaNode = atoi(argv[++a]);
+        }
+        else if (!strcasecmp(argv[a], "--clip") && a + 1 < argc)
+        {
+            clipPath = argv[++a];
+        }
+        else if (!strcasecmp(argv[a], "--format") && a + 1 < argc)
+        {
+            clipCodec = parseClipFormat(argv[++a]);
+            if (!clipCodec)
+            {
+                std::cout << "unknown clip format: " << argv[a] << "\n";
+                return 1;
+            }
+        }
+        else if (!strcasecmp(argv[a], "--size") && a + 1 < argc)
+        {
+            if (sscanf(argv[++a], "%dx%d", &clipWidth, &clipHeight) != 2)
+            {
+                std::cout << "clip size must be <width>x<height>\n";
+                return 1;
+            }
+        }
+        else if (!strcasecmp(argv[a], "--audio") && a + 1 < argc)
+        {
+            if (!parseAudioSignal(argv[++a], audioOptions.signal))
+            {
+                std::cout << "unknown audio signal: " << argv[a] << "\n";
+                return 1;
+            }
+            if (audioOptions.signal == OMTAudioSignal_Tone)
+            {
+                audioOptions.level = 0.125f; // -18 dBFS line-up
+            }
+        }
+        else if (!strcasecmp(argv[a], "--channels") && a + 1 < argc)
+        {
+            audioOptions.channels = atoi(argv[++a]);
+            if (audioOptions.channels < 1 || audioOptions.channels > 32)
+            {
+                std::cout << "channels must be between 1 and 32\n";
+                return 1;
+            }
+        }
+        else if (!strcasecmp(argv[a], "--benchaudio"))
+        {
+            benchAudio = true;
+        }
+        else if (!strcasecmp(argv[a], "--benchformats"))
+        {
+            benchFormatFrames = 300;
+            if (a + 1 < argc && atoi(argv[a + 1]) > 0)
+            {
+                benchFormatFrames = atoi(argv[++a]);
+            }
+        }
+        else if (!strcasecmp(argv[a], "--clocking") && a + 1 < argc)
+        {
+            a++;
+            if (!strcasecmp(argv[a], "omt")) clocking = SendClocking_Omt;
+            else if (!strcasecmp(argv[a], "unclocked")) clocking = SendClocking_Unclocked;
+            else if (!strcasecmp(argv[a], "paced")) clocking = SendClocking_Paced;
+            else
+            {
+                std::cout << "unknown clocking: " << argv[a] << "\n";
+                return 1;
+            }
+        }
+        else if (!strcasecmp(argv[a], "--highbitdepth") && a + 1 < argc)
+        {
+            a++;
+            if (!strcasecmp(argv[a], "p216")) highBitDepthCodec = OMTCodec_P216;
+            else if (!strcasecmp(argv[a], "pa16")) highBitDepthCodec = OMTCodec_PA16;
+            else
+            {
+                std::cout << "high bit depth format must be p216 or pa16\n";
+                return 1;
+            }
+        }
+        else if (!strcasecmp(argv[a], "--benchconvert"))
+        {
+            benchConvertFrames = 200;
+            if (a + 1 < argc && atoi(argv[a + 1]) > 0)
+            {
+                benchConvertFrames = atoi(argv[++a]);
+            }
+        }
+        else if (!strcasecmp(argv[a], "--probe"))
+        {
+            probe = true;
+        }
+        else if (!strcasecmp(argv[a], "--barcode"))
+        {
+            probe = true;
+            barcode = true;
+        }
+        else if (!strcasecmp(argv[a], "--adaptive"))
+        {
+            adaptive = true;
+        }
+        else if (!strcasecmp(argv[a], "--target-load") && a + 1 < argc)
+        {
+            qualityOptions.targetLoad = atof(argv[++a]);
+            qualityOptions.recoverLoad = qualityOptions.targetLoad * 0.6;
+        }
+        else if (!strcasecmp(argv[a], "--json"))
+        {
+            benchJson = true;
+        }
+        else if (!strcasecmp(argv[a], "--load") && a + 1 < argc)
+        {
+            loadSenders = atoi(argv[++a]);
+        }
+        else if (!strcasecmp(argv[a], "--duration") && a + 1 < argc)
+        {
+            loadSeconds = atoi(argv[++a]);
+        }
+        else if (!strcasecmp(argv[a], "--spec") && a + 1 < argc)
+        {
+            LoadSpec spec;
+            if (!parseLoadSpec(argv[++a], spec))
+            {
+                std::cout << "invalid sender spec: " << argv[a] << "\n";
+                return 1;
+            }
+            loadSpecs.push_back(spec);
+        }
+    }
+    // the benchmark tables go to stdout on their own
+    if (!benchFormatFrames)
+    {
+        std::cout << "OMTSendTest\n";
+    }
+
+    if (benchAudio)
+    {
+        benchmarkAudio(audioOptions.channels);
+        return 0;
+    }
+    OMTFramePool pool(poolOptions);
+    if (benchConvertFrames > 0)
+    {
+        benchmarkConvert(benchConvertFrames, pool);
+        return 0;
+    }
+    if (benchFormatFrames > 0)
+    {
+        omt_setloggingfilename("omtsendtest.log");
+        runFormatBenchmark(benchFormatFrames, benchJson, pool);
+        return 0;
+    }
+    if (loadSenders > 0)
+    {
+        if (loadSpecs.empty())
+        {
+            loadSpecs.push_back(LoadSpec());
+        }
+        omt_setloggingfilename("omtsendtest.log");
+        runLoadTest(loadSpecs, loadSenders, loadSeconds > 0 ? loadSeconds : 30, pool);
+        return 0;
+    }
+
+    OMTClipSource clip(pool);
+    if (clipPath)
+    {
+        std::string error;
+        if (!clip.open(clipPath, clipCodec, clipWidth, clipHeight, error))
+        {
+            std::cout << "clip.open.failed: " << error << "\n";
+            return 1;
+        }
+        std::cout << "clip.open.success: " << clip.width() << "x" << clip.height() << ", " << clip.frameCount() << " frames\n";
+    }
 
     string filename = "omtsendtest.log";
     omt_setloggingfilename(filename.c_str());
@@ -65,7 +877,8 @@ int main()
     string name = "Test";
     
     // Create the OMT output stream using the default (medium) quality.
-    omt_send_t * snd = omt_send_create(name.c_str(), OMTQuality_Default);
+    // In adaptive mode start from the best step and let the controller work down from there.
+    omt_send_t * snd = omt_send_create(name.c_str(), adaptive ? OMTQuality_High : OMTQuality_Default);
     if (snd)
     {
         std::cout << "omt_send_create.success\n";
@@ -114,14 +927,24 @@ int main()
         // Total size of the data
         video_frame.DataLength = video_frame.Stride * video_frame.Height;
 
-        // A pointer to the UYVY data which will be passed to OMT
-        video_frame.Data = malloc(video_frame.DataLength);
-        
-        
-    
+        // A clip brings its own format, size and, for Y4M, frame rate
+        if (clipPath)
+        {
+            video_frame.Codec = (OMTCodec)clip.codec();
+            video_frame.Width = clip.width();
+            video_frame.Height = clip.height();
+            video_frame.Stride = clip.stride();
+            video_frame.DataLength = clip.frameLength();
+        }
+
         // The target frame rate expressed as numerator and denominator. In this case 60 fps
         video_frame.FrameRateN = 60000;
         video_frame.FrameRateD = 1000;
+        if (clip.frameRateN() > 0)
+        {
+            video_frame.FrameRateN = clip.frameRateN();
+            video_frame.FrameRateD = clip.frameRateD();
+        }
         
         // we are passing uncompressed, rather than pre-compressed VMX codec data, so set these to zero
     //    video_frame.CompressedData = NULL;
@@ -134,24 +957,74 @@ int main()
       
 		// load  sample UYVY data from the california-1080-uyvy.yuv file
         // make sure its in the same folder with the built executable
-        void * uyvy = malloc(video_frame.DataLength);
-        std::ifstream file("california-1080-uyvy.yuv", std::ios::binary | std::ios::in | std::ios::ate);
-        if (file.is_open())
+        void * uyvy = NULL;
+        void * highBitDepth = NULL;
+        std::unique_ptr<OMTFrameRing> frames;
+        if (!clipPath)
         {
-            std::streamsize size = file.tellg();
-            file.seekg(0, std::ios::beg);
-            file.read((char*)uyvy, size);
-            file.close();
+            uyvy = pool.acquire(video_frame.Codec, video_frame.Width, video_frame.Height, video_frame.Stride, video_frame.DataLength);
+            std::ifstream file("california-1080-uyvy.yuv", std::ios::binary | std::ios::in | std::ios::ate);
+            if (file.is_open())
+            {
+                std::streamsize size = file.tellg();
+                if (size != video_frame.DataLength)
+                {
+                    std::cout << "california-1080-uyvy.yuv is " << size << " bytes, expected " << video_frame.DataLength << "\n";
+                }
+                file.seekg(0, std::ios::beg);
+                file.read((char*)uyvy, size < video_frame.DataLength ? size : video_frame.DataLength);
+                file.close();
+            }
+
+            // Up-convert to 16 bits per sample to exercise the high bit depth encoder. The moving lines
+            // are then drawn into the 16-bit luma plane.
+            void* image = uyvy;
+            if (highBitDepthCodec)
+            {
+                int length = video_frame.Width * video_frame.Height * (highBitDepthCodec == OMTCodec_PA16 ? 6 : 4);
+                highBitDepth = pool.acquire(highBitDepthCodec, video_frame.Width, video_frame.Height, video_frame.Width * 2, length);
+                if (highBitDepthCodec == OMTCodec_PA16)
+                {
+                    omtConvertUyvyToPa16((const uint8_t*)uyvy, video_frame.Stride, (uint8_t*)highBitDepth, video_frame.Width, video_frame.Height);
+                    video_frame.Flags = (OMTVideoFlags)(OMTVideoFlags_HighBitDepth | OMTVideoFlags_Alpha);
+                }
+                else
+                {
+                    omtConvertUyvyToP216((const uint8_t*)uyvy, video_frame.Stride, (uint8_t*)highBitDepth, video_frame.Width, video_frame.Height);
+                    video_frame.Flags = OMTVideoFlags_HighBitDepth;
+                }
+                video_frame.Codec = highBitDepthCodec;
+                video_frame.Stride = video_frame.Width * 2;
+                video_frame.DataLength = length;
+                image = highBitDepth;
+                std::cout << "highbitdepth: sending " << (highBitDepthCodec == OMTCodec_PA16 ? "PA16" : "P216")
+                          << ", converted with " << omtPixelConvertSimd() << "\n";
+            }
+
+            // Output buffers handed to OMT. Each starts as a copy of the image and afterwards only the
+            // lines drawn into it are restored and redrawn, rather than copying the whole image per frame.
+            frames.reset(new OMTFrameRing(pool, video_frame.Codec, video_frame.Width, video_frame.Height, video_frame.Stride, video_frame.DataLength, image));
         }
 
-        // create some audio a stereo buffer exactly 1 frame long
-        float * audioBuffer = (float *)malloc(800 * sizeof(float) * 2 );
-        // fill the buffer with noise
-        srand((unsigned int)time(NULL));
-        for (int z=0;z<1600;z++)
+        // create some audio a buffer exactly 1 frame long. 48000 samples rarely divide evenly between the
+        // frames of a second (1601.6 at 29.97), so each frame takes its share and the remainder carries over.
+        const int sampleRate = 48000;
+        int channels = audioOptions.channels;
+        int64_t audioRate = (int64_t)sampleRate * video_frame.FrameRateD;
+        int64_t audioRemainder = 0;
+        int maxAudioSamples = (int)((audioRate + video_frame.FrameRateN - 1) / video_frame.FrameRateN);
+        auto nextAudioSamples = [&]()
         {
-            audioBuffer[z] = rand_FloatRange(-1.0,+1.0);
-        }
+            int64_t total = audioRate + audioRemainder;
+            audioRemainder = total % video_frame.FrameRateN;
+            return (int)(total / video_frame.FrameRateN);
+        };
+        float * audioBuffer = (float *)pool.acquire(OMTCodec_FPA1, 0, 0, 0, maxAudioSamples * sizeof(float) * channels);
+        // fill the buffer with the test signal, noise by default
+        audioOptions.seed = (uint32_t)time(NULL);
+        OMTAudioGenerator audioGenerator(audioOptions);
+        int audioSamples = nextAudioSamples();
+        audioGenerator.render(audioBuffer, audioSamples);
 
         // prepare an OMTMediaFrame for the audio
         OMTMediaFrame audio_frame = {};
@@ -159,11 +1032,11 @@ int main()
         audio_frame.Type = OMTFrameType_Audio;
         audio_frame.Timestamp = -1;
         audio_frame.Codec = OMTCodec_FPA1; // floating point planar data format
-        audio_frame.SampleRate = 48000;
-        audio_frame.Channels = 2;
-        audio_frame.SamplesPerChannel = 800; // we are sending exactly 1 frame of audio per 60fps video frame
+        audio_frame.SampleRate = sampleRate;
+        audio_frame.Channels = channels;
+        audio_frame.SamplesPerChannel = audioSamples; // we are sending exactly 1 frame of audio per video frame
         audio_frame.Data = (void *)audioBuffer;
-        audio_frame.DataLength = (800 * sizeof(float) * 2);
+        audio_frame.DataLength = (audioSamples * sizeof(float) * channels);
         audio_frame.FrameMetadata = NULL;
         audio_frame.FrameMetadataLength = 0;
         
@@ -173,46 +1046,218 @@ int main()
         int linePos = 0;
 
         
-		// structs ready to receive streaming statistics and tally
-        OMTTally tally = {};
-        OMTStatistics stats = {};
+		// tally, metadata from receivers, connections and statistics are collected on a control
+		// thread, so the loop below only calls omt_send and reads the latest snapshot
+        std::unique_ptr<OMTSendControl> control(new OMTSendControl(snd));
+        control->start();
+        uint64_t metadataSeen = 0;
+
+        // Quality ladder for --adaptive, best first. Resolution is only halved for the generated image,
+        // a clip is sent at its own size.
+        std::unique_ptr<OMTQualityController> quality;
+        void* scaled = NULL;
+        int fullWidth = video_frame.Width, fullHeight = video_frame.Height, fullStride = video_frame.Stride;
+        if (adaptive)
+        {
+            std::vector<OMTQualityStep> ladder = { { OMTQuality_High, 1 }, { OMTQuality_Medium, 1 }, { OMTQuality_Low, 1 } };
+            if (!clipPath && video_frame.Codec == OMTCodec_UYVY && fullWidth % 8 == 0 && fullHeight % 4 == 0)
+            {
+                ladder.push_back({ OMTQuality_Low, 2 });
+            }
+            quality.reset(new OMTQualityController(qualityOptions, ladder, video_frame.FrameRateN, video_frame.FrameRateD));
+        }
 
         int frameCount = 0;
         int bytes = 0;
+
+        // In the unclocked and paced modes timestamps are derived from the frame number, so they
+        // advance by exactly one frame duration without drift and OMT does not throttle the sends
+        typedef std::chrono::steady_clock Clock;
+        const Clock::duration frameDuration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::nanoseconds(1000000000LL * video_frame.FrameRateD / video_frame.FrameRateN));
+        Clock::time_point loopStart = Clock::now();
+        Clock::time_point intervalStart = loopStart;
+        Clock::time_point deadline = intervalStart;
+        int framesSent = 0;
+        int64_t frameNumber = 0;
+        uint64_t probeSequence = 0;
+        char probeText[128];
+        if (barcode && clipPath)
+        {
+            // clip frames are sent from a read-only mapping
+            std::cout << "probe: no barcode on clips, metadata only\n";
+            barcode = false;
+        }
+        int64_t lateTotalUs = 0, lateMaxUs = 0;
+        int missed = 0, skipped = 0;
+
         for (int i = 0; i < 10000; i++)
         {
+            if (clocking != SendClocking_Omt)
+            {
+                video_frame.Timestamp = frameNumber * 10000000LL * video_frame.FrameRateD / video_frame.FrameRateN;
+                audio_frame.Timestamp = video_frame.Timestamp;
+            }
+            if (clocking == SendClocking_Paced)
+            {
+                // Sleep to just short of the deadline, then spin for the rest to avoid scheduler wakeup jitter
+                std::this_thread::sleep_until(deadline - std::chrono::milliseconds(1));
+                while (Clock::now() < deadline)
+                {
+                }
+                int64_t lateUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - deadline).count();
+                lateTotalUs += lateUs;
+                if (lateUs > lateMaxUs)
+                {
+                    lateMaxUs = lateUs;
+                }
+            }
 
-       		//used to create a dynamically changing image by overwriting 2 lines moving down the image
-           memcpy(video_frame.Data, uyvy, video_frame.DataLength);
-           memcpy((char*)video_frame.Data + linePos, twoLines, video_frame.Stride * 2);
-           linePos += video_frame.Stride * 2;
-           if (linePos >= video_frame.DataLength)
-           { 
-             	linePos = 0;
-           }
+            if (clipPath)
+            {
+                // clip frames are sent straight from the mapped file
+                video_frame.Data = (void*)clip.nextFrame();
+                if (!video_frame.Data)
+                {
+                    std::cout << "clip.read.failed\n";
+                    break;
+                }
+            }
+            else
+            {
+                //used to create a dynamically changing image by overwriting 2 lines moving down the image
+                video_frame.Data = frames->next();
+                if (!video_frame.Data)
+                {
+                    std::cout << "frame_ring.acquire.failed\n";
+                    break;
+                }
+                frames->draw(linePos, twoLines, video_frame.Stride * 2);
+                linePos += video_frame.Stride * 2;
+                if (linePos >= video_frame.Stride * video_frame.Height)
+                {
+                    linePos = 0;
+                }
+            }
+
+            if (probe)
+            {
+                // stamped as late as possible. With OMT clocking the send may then wait for its slot,
+                // which is counted as latency; --clocking paced leaves that out.
+                int64_t sent = omtProbeNow();
+                if (barcode)
+                {
+                    omtProbeDrawBarcode(video_frame.Data, video_frame.Codec, video_frame.Width, video_frame.Height, video_frame.Stride, probeSequence, sent);
+                }
+                video_frame.FrameMetadataLength = omtProbeWriteMetadata(probeText, sizeof(probeText), probeSequence, sent);
+                video_frame.FrameMetadata = video_frame.FrameMetadataLength ? probeText : NULL;
+                probeSequence++;
+            }
 
 			// Send out the prepared OMT Video Frame.
             bytes += omt_send(snd, &video_frame);
+            frameNumber++;
+            framesSent++;
+
+            if (clocking == SendClocking_Paced)
+            {
+                deadline += frameDuration;
+                Clock::time_point now = Clock::now();
+                if (now > deadline)
+                {
+                    // Finished after the next frame was due
+                    missed++;
+                    if (now - deadline >= frameDuration)
+                    {
+                        // A whole frame behind: drop the frames that could not be sent, as a live source would
+                        int64_t behind = (now - deadline) / frameDuration;
+                        deadline += behind * frameDuration;
+                        frameNumber += behind;
+                        skipped += (int)behind;
+                    }
+                }
+            }
 
 			// gather and output statistics once per second
             frameCount += 1;
-            if (frameCount >= 60) 
+            Clock::time_point now = Clock::now();
+            if (now - intervalStart >= std::chrono::seconds(1))
             {
+                double seconds = std::chrono::duration<double>(now - intervalStart).count();
+                std::cout << "omt_send.fps: " << frameCount / seconds << "\n";
+                if (clocking == SendClocking_Paced)
+                {
+                    std::cout << "omt_send.pacing: late mean " << lateTotalUs / frameCount << " us max " << lateMaxUs
+                              << " us, missed " << missed << ", skipped " << skipped << "\n";
+                    lateTotalUs = 0;
+                    lateMaxUs = 0;
+                    missed = 0;
+                    skipped = 0;
+                }
+                intervalStart = now;
+
                 std::cout << "omt_send.ok: " << bytes << "\n";
-                omt_send_gettally(snd, 0, &tally);
-                std::cout << "omt_send.tally: " << tally.preview << " " << tally.program << "\n";
+                OMTSendControlSnapshot status = control->snapshot();
+                std::cout << "omt_send.tally: " << status.tally.preview << " " << status.tally.program << "\n";
 
-                OMTMediaFrame* frame = omt_send_receive(snd, 0);
-                if (frame) {
-                    char* sz = (char*)frame->Data;
-                    std::cout << "omt_send.meta: " << sz << "\n";
+                if (status.metadataFrames != metadataSeen)
+                {
+                    metadataSeen = status.metadataFrames;
+                    std::cout << "omt_send.meta: " << status.lastMetadata << "\n";
                 }
 
-                int connections = omt_send_connections(snd);
-                std::cout << "omt_send.connections: " << connections << "\n";
+                std::cout << "omt_send.connections: " << status.connections << "\n";
+                std::cout << "omt_send_getvideostatistics: Bytes: " << status.video.BytesSent << " Frames: " << status.video.Frames << "\n";
+
+                if (quality && quality->update(status.video))
+                {
+                    // Quality is fixed at creation, so the sender is replaced; receivers reconnect by name
+                    const OMTQualityStep& step = quality->step();
+                    std::cout << "omt_send.quality: encode load " << quality->load() << ", moving to step " << quality->stepIndex()
+                              << " (quality " << step.quality << ", 1/" << step.divisor << " resolution)\n";
+                    control.reset();
+                    omt_send_destroy(snd);
+                    snd = omt_send_create(name.c_str(), step.quality);
+                    if (!snd)
+                    {
+                        std::cout << "omt_send_create.failed\n";
+                        break;
+                    }
+                    omt_send_setsenderinformation(snd, &info);
+                    control.reset(new OMTSendControl(snd));
+                    control->start();
+
+                    if (frames && video_frame.Width != fullWidth / step.divisor)
+                    {
+                        void* image = uyvy;
+                        video_frame.Width = fullWidth / step.divisor;
+                        video_frame.Height = fullHeight / step.divisor;
+                        video_frame.Stride = video_frame.Width * 2;
+                        video_frame.DataLength = video_frame.Stride * video_frame.Height;
+                        if (step.divisor > 1)
+                        {
+                            if (!scaled)
+                            {
+                                scaled = pool.acquire(video_frame.Codec, video_frame.Width, video_frame.Height, video_frame.Stride, video_frame.DataLength);
+                                omtScaleUyvyHalf((const uint8_t*)uyvy, fullStride, (uint8_t*)scaled, video_frame.Stride, fullWidth, fullHeight);
+                            }
+                            image = scaled;
+                        }
+                        frames.reset();
+                        frames.reset(new OMTFrameRing(pool, video_frame.Codec, video_frame.Width, video_frame.Height, video_frame.Stride, video_frame.DataLength, image));
+                        linePos = 0;
+                    }
+                    quality->reset();
+                }
+                else if (quality)
+                {
+                    std::cout << "omt_send.quality: encode load " << quality->load() << ", step " << quality->stepIndex() << "\n";
+                }
 
-                omt_send_getvideostatistics(snd, &stats);
-                std::cout << "omt_send_getvideostatistics: Bytes: " << stats.BytesSent << " Frames: " << stats.Frames << "\n";
+                if (frames)
+                {
+                    std::cout << "frame_ring.bytes_per_frame: " << frames->takeBytesWritten() / frameCount << " of " << video_frame.DataLength << "\n";
+                }
 
                 frameCount = 0;
                 bytes = 0;
@@ -220,16 +1265,34 @@ int main()
             
             // Send out the prepared OMT Audio Frame.
             omt_send(snd, &audio_frame);
-            // make some different noise for next frame
-            for (int z=0;z<1600;z++)
-            {
-                audioBuffer[z] = rand_FloatRange(-1.0,+1.0);
-            }
+            // continue the signal (or make some different noise) for next frame
+            audioSamples = nextAudioSamples();
+            audioGenerator.render(audioBuffer, audioSamples);
+            audio_frame.SamplesPerChannel = audioSamples;
+            audio_frame.DataLength = (audioSamples * sizeof(float) * channels);
         }
 
+        double loopSeconds = std::chrono::duration<double>(Clock::now() - loopStart).count();
+        std::cout << "omt_send.total: " << framesSent << " frames in " << loopSeconds << " s, " << framesSent / loopSeconds << " fps\n";
+
 		// close and clean up the OMT output
-        omt_send_destroy(snd);
-        std::cout << "omt_send_destroy.success\n";
+        control.reset();
+        if (snd)
+        {
+            omt_send_destroy(snd);
+            std::cout << "omt_send_destroy.success\n";
+        }
+
+        frames.reset();
+        pool.release(uyvy);
+        pool.release(scaled);
+        pool.release(highBitDepth);
+        pool.release(audioBuffer);
+        free(twoLines);
+
+        OMTFramePoolStats poolStats = pool.stats();
+        std::cout << "frame_pool: hits " << poolStats.hits << " misses " << poolStats.misses
+                  << " resident " << poolStats.residentBytes << " bytes (" << poolStats.hugePageBytes << " huge)\n";
     }
     else {
         std::cout << "omt_send_create.failed\n";
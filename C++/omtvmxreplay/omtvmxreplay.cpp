@@ -0,0 +1,604 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 Open Media Transport Contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+*/
+
+
+/*  omtvmxreplay.cpp captures compressed VMX1 video from an OMT source into an indexed file once,
+	and replays that file through any number of OMT senders without encoding. It also replays the
+	uncompressed recordings made by omtrecvtest --record, which OMT then encodes as it sends.
+
+	Because the frames are already compressed, a sender costs little more than the network
+	traffic it generates, so one machine can stand in for dozens of real sources when testing
+	networks and receivers.
+
+	record keeps the audio as well and takes any number of sources at once, one file each, named
+	after the source. Receiving compressed frames costs almost nothing, and the file writes are
+	large, aligned and asynchronous (see omt_async_writer.h), so one host can record many sources.
+	With --direct the files bypass the page cache. replay sends the audio of such a file alongside
+	the video and --start jumps straight to a point in it using the file's index.
+
+	omtvmxreplay capture "HOST (Source)" <file> [frames]
+	omtvmxreplay record <directory> "HOST (Source)" ["HOST (Source)" ...] [--duration seconds] [--direct]
+	omtvmxreplay replay <file> [--senders n] [--rate fps] [--unclocked] [--duration seconds] [--start seconds]  */
+
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// The header for the C/C++ wrapper of OMT
+#include "../ndi2omt/libomt.h"
+
+// Indexed file of compressed frames, read through mmap
+#include "../common/omt_media_file.h"
+
+using namespace std;
+
+std::atomic<bool> running(true);
+
+void signalHandler(int)
+{
+    running = false;
+}
+
+// Receives VMX1 frames without decoding them and appends them to the file
+int capture(const char* source, const char* path, int frames)
+{
+    OMTMediaFileWriter writer;
+    std::string error;
+    if (!writer.open(path, error))
+    {
+        std::cout << "capture.open.failed: " << error << "\n";
+        return 1;
+    }
+
+    omt_receive_t* recv = omt_receive_create(source, OMTFrameType_Video, OMTPreferredVideoFormat_UYVYorUYVAorP216orPA16, OMTReceiveFlags_CompressedOnly);
+    if (!recv)
+    {
+        std::cout << "omt_receive_create.failed\n";
+        return 1;
+    }
+    std::cout << "capture: " << frames << " frames from " << source << " to " << path << "\n";
+
+    int captured = 0;
+    while (running && captured < frames)
+    {
+        OMTMediaFrame* frame = omt_receive(recv, OMTFrameType_Video, 1000);
+        if (!frame || frame->Codec != OMTCodec_VMX1 || !frame->CompressedData || frame->CompressedLength <= 0)
+        {
+            continue;
+        }
+        if (captured == 0)
+        {
+            OMTMediaFileHeader& header = writer.header();
+            header.width = frame->Width;
+            header.height = frame->Height;
+            header.frameRateN = frame->FrameRateN;
+            header.frameRateD = frame->FrameRateD;
+            header.aspectRatio = frame->AspectRatio;
+            header.colorSpace = frame->ColorSpace;
+            header.videoFlags = frame->Flags;
+            std::cout << "capture.format: " << frame->Width << "x" << frame->Height << " @ "
+                      << frame->FrameRateN << "/" << frame->FrameRateD << "\n";
+        }
+        if (!writer.write(OMTFrameType_Video, OMTCodec_VMX1, frame->Timestamp, frame->Flags, frame->CompressedData, (uint32_t)frame->CompressedLength))
+        {
+            std::cout << "capture.write.failed\n";
+            break;
+        }
+        captured++;
+        if (captured % 60 == 0)
+        {
+            std::cout << "capture: " << captured << " frames, " << writer.bytesWritten() / (1024 * 1024) << " MB\n";
+        }
+    }
+    omt_receive_destroy(recv);
+
+    if (!writer.close())
+    {
+        std::cout << "capture.close.failed\n";
+        return 1;
+    }
+    std::cout << "capture.done: " << captured << " frames\n";
+    return 0;
+}
+
+// One source being recorded: its receiver, its file and the threads receiving video and audio
+struct Recording
+{
+    std::string source;
+    std::string path;
+    omt_receive_t* recv = NULL;
+    std::unique_ptr<OMTMediaFileWriter> writer;
+    std::mutex writerMutex;         // video and audio threads share the writer
+    bool haveVideo = false;
+    bool haveAudio = false;
+    bool failed = false;
+    std::thread threads[2];
+
+    // Read and reset once per second by the reporting loop
+    std::atomic<int64_t> videoFrames{0};
+    std::atomic<int64_t> audioFrames{0};
+    std::atomic<int64_t> skipped{0};        // video that arrived uncompressed
+};
+
+// Receives one frame type of a source and appends it to the file
+void recordLoop(Recording* recording, OMTFrameType type, int timeoutMs)
+{
+    while (running)
+    {
+        OMTMediaFrame* frame = omt_receive(recording->recv, type, timeoutMs);
+        if (!frame)
+        {
+            continue;
+        }
+        const void* data = frame->Data;
+        int length = frame->DataLength;
+        uint32_t info = (uint32_t)frame->SamplesPerChannel;
+        if (type == OMTFrameType_Video)
+        {
+            if (frame->Codec != OMTCodec_VMX1 || !frame->CompressedData || frame->CompressedLength <= 0)
+            {
+                recording->skipped++;
+                continue;
+            }
+            data = frame->CompressedData;
+            length = frame->CompressedLength;
+            info = (uint32_t)frame->Flags;
+        }
+        else if (frame->Codec != OMTCodec_FPA1 || !data || length <= 0)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(recording->writerMutex);
+        if (recording->failed)
+        {
+            continue;
+        }
+        OMTMediaFileHeader& header = recording->writer->header();
+        if (type == OMTFrameType_Video && !recording->haveVideo)
+        {
+            header.width = frame->Width;
+            header.height = frame->Height;
+            header.frameRateN = frame->FrameRateN;
+            header.frameRateD = frame->FrameRateD;
+            header.aspectRatio = frame->AspectRatio;
+            header.colorSpace = frame->ColorSpace;
+            header.videoFlags = frame->Flags;
+            recording->haveVideo = true;
+        }
+        if (type == OMTFrameType_Audio && !recording->haveAudio)
+        {
+            header.sampleRate = frame->SampleRate;
+            header.channels = frame->Channels;
+            recording->haveAudio = true;
+        }
+        if (!recording->writer->write(type, frame->Codec, frame->Timestamp, info, data, (uint32_t)length))
+        {
+            std::cout << "record.write.failed: " << recording->path << "\n";
+            recording->failed = true;
+            continue;
+        }
+        if (type == OMTFrameType_Video)
+        {
+            recording->videoFrames++;
+        }
+        else
+        {
+            recording->audioFrames++;
+        }
+    }
+}
+
+int record(const char* directory, const std::vector<std::string>& sources, int seconds, bool direct)
+{
+    OMTAsyncWriterOptions options;
+    options.direct = direct;
+
+    std::vector<std::unique_ptr<Recording>> recordings;
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        std::unique_ptr<Recording> recording(new Recording());
+        recording->source = sources[i];
+
+        // Name the file after the part of "HOST (NAME)" in brackets
+        std::string name = sources[i];
+        size_t open = name.find('(');
+        size_t close = name.rfind(')');
+        if (open != std::string::npos && close != std::string::npos && close > open + 1)
+        {
+            name = name.substr(open + 1, close - open - 1);
+        }
+        for (size_t c = 0; c < name.size(); c++)
+        {
+            if (name[c] == '/' || name[c] == '\\' || name[c] == ':')
+            {
+                name[c] = '_';
+            }
+        }
+        recording->path = std::string(directory) + "/" + name + ".omtmedia";
+
+        recording->writer.reset(new OMTMediaFileWriter(options));
+        std::string error;
+        if (!recording->writer->open(recording->path.c_str(), error))
+        {
+            std::cout << "record.open.failed: " << error << "\n";
+            continue;
+        }
+        recording->recv = omt_receive_create(sources[i].c_str(), (OMTFrameType)(OMTFrameType_Video | OMTFrameType_Audio),
+                                             OMTPreferredVideoFormat_UYVYorUYVAorP216orPA16, OMTReceiveFlags_CompressedOnly);
+        if (!recording->recv)
+        {
+            std::cout << "omt_receive_create.failed: " << sources[i] << "\n";
+            continue;
+        }
+        std::cout << "record: " << sources[i] << " to " << recording->path << "\n";
+        recordings.push_back(std::move(recording));
+    }
+    if (recordings.empty())
+    {
+        return 1;
+    }
+    for (size_t i = 0; i < recordings.size(); i++)
+    {
+        recordings[i]->threads[0] = std::thread(recordLoop, recordings[i].get(), OMTFrameType_Video, 40);
+        recordings[i]->threads[1] = std::thread(recordLoop, recordings[i].get(), OMTFrameType_Audio, 20);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> lastBytes(recordings.size(), 0);
+    for (int t = 1; running && (seconds <= 0 || t <= seconds); t++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::seconds(t));
+        double totalMBps = 0;
+        for (size_t i = 0; i < recordings.size(); i++)
+        {
+            Recording& recording = *recordings[i];
+            OMTAsyncWriterStats stats;
+            {
+                std::lock_guard<std::mutex> lock(recording.writerMutex);
+                stats = recording.writer->stats();
+            }
+            double mbps = (stats.bytesWritten - lastBytes[i]) / 1000000.0;
+            lastBytes[i] = stats.bytesWritten;
+            totalMBps += mbps;
+            std::cout << "record: t=" << t << "s " << recording.source << " " << recording.videoFrames.exchange(0) << " fps "
+                      << recording.audioFrames.exchange(0) << " audio, " << mbps << " MB/s to disk, " << stats.inFlight
+                      << " writes in flight, " << stats.stalls << " stalls";
+            int64_t skipped = recording.skipped.exchange(0);
+            if (skipped)
+            {
+                std::cout << ", " << skipped << " uncompressed skipped";
+            }
+            std::cout << "\n";
+        }
+        if (recordings.size() > 1)
+        {
+            std::cout << "record: t=" << t << "s total " << totalMBps << " MB/s\n";
+        }
+    }
+
+    running = false;
+    int result = 0;
+    for (size_t i = 0; i < recordings.size(); i++)
+    {
+        Recording& recording = *recordings[i];
+        recording.threads[0].join();
+        recording.threads[1].join();
+        omt_receive_destroy(recording.recv);
+        size_t frames = recording.writer->frameCount();
+        if (!recording.writer->close() || recording.failed)
+        {
+            std::cout << "record.close.failed: " << recording.path << "\n";
+            result = 1;
+            continue;
+        }
+        std::cout << "record.done: " << recording.path << " " << frames << " frames\n";
+    }
+    return result;
+}
+
+struct ReplaySender
+{
+    omt_send_t* snd = NULL;
+    std::thread thread;
+    OMTStatistics last = {};
+};
+
+// Video codecs omt_send accepts. Recordings can hold others, such as the I420, v210 and planar RGB
+// frames of omtrecvtest --convert --record, which are for other tools to read.
+bool sendableVideoCodec(uint32_t codec)
+{
+    switch (codec)
+    {
+    case OMTCodec_VMX1:
+    case OMTCodec_UYVY:
+    case OMTCodec_YUY2:
+    case OMTCodec_NV12:
+    case OMTCodec_YV12:
+    case OMTCodec_BGRA:
+    case OMTCodec_UYVA:
+    case OMTCodec_P216:
+    case OMTCodec_PA16:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Sends the captured frames in a loop, straight from the mapping
+void replayLoop(const OMTMediaFileReader* file, omt_send_t* snd, uint32_t firstFrame, int rateN, int rateD, bool unclocked)
+{
+    const OMTMediaFileHeader& header = file->header();
+    OMTMediaFrame frame = {};
+    frame.Type = OMTFrameType_Video;
+    frame.Codec = OMTCodec_VMX1;
+    frame.Width = header.width;
+    frame.Height = header.height;
+    frame.FrameRateN = rateN;
+    frame.FrameRateD = rateD;
+    frame.AspectRatio = header.aspectRatio;
+    frame.ColorSpace = (OMTColorSpace)header.colorSpace;
+    frame.Timestamp = -1;
+
+    // Recorded audio goes out between the video frames it arrived between
+    OMTMediaFrame audio = {};
+    audio.Type = OMTFrameType_Audio;
+    audio.Codec = OMTCodec_FPA1;
+    audio.SampleRate = header.sampleRate;
+    audio.Channels = header.channels;
+    audio.Timestamp = -1;
+
+    int64_t frameNumber = 0;
+    int64_t samples = 0;
+    uint32_t index = firstFrame;
+    while (running)
+    {
+        uint32_t current = index;
+        const OMTMediaFileEntry& entry = file->entry(current);
+        index = (index + 1) % file->frameCount();
+        if (entry.type == OMTFrameType_Audio)
+        {
+            if (audio.SampleRate <= 0 || audio.Channels <= 0)
+            {
+                continue;
+            }
+            audio.SamplesPerChannel = (int)entry.info;
+            audio.Data = (void*)file->data(current);
+            audio.DataLength = (int)entry.length;
+            if (unclocked)
+            {
+                audio.Timestamp = samples * 10000000LL / audio.SampleRate;
+            }
+            omt_send(snd, &audio);
+            samples += audio.SamplesPerChannel;
+            continue;
+        }
+        if (entry.type != OMTFrameType_Video)
+        {
+            continue;
+        }
+        frame.Codec = (OMTCodec)entry.codec;
+        frame.Stride = entry.codec == OMTCodec_VMX1 ? 0 : header.stride;
+        frame.Flags = (OMTVideoFlags)entry.info;
+        frame.Data = (void*)file->data(current);
+        frame.DataLength = (int)entry.length;
+        if (unclocked)
+        {
+            // Explicit timestamps keep OMT from holding the send to the frame rate
+            frame.Timestamp = frameNumber * 10000000LL * rateD / rateN;
+        }
+        omt_send(snd, &frame);
+        frameNumber++;
+    }
+}
+
+int replay(const char* path, int senderCount, double rate, bool unclocked, int seconds, double startSeconds)
+{
+    OMTMediaFileReader file;
+    std::string error;
+    if (!file.open(path, error))
+    {
+        std::cout << "replay.open.failed: " << error << "\n";
+        return 1;
+    }
+    if (file.frameCount() == 0)
+    {
+        std::cout << "replay: file holds no frames\n";
+        return 1;
+    }
+    for (uint32_t i = 0; i < file.frameCount(); i++)
+    {
+        const OMTMediaFileEntry& entry = file.entry(i);
+        if (entry.type == OMTFrameType_Video && !sendableVideoCodec(entry.codec))
+        {
+            char codec[5] = { (char)entry.codec, (char)(entry.codec >> 8), (char)(entry.codec >> 16), (char)(entry.codec >> 24), 0 };
+            std::cout << "replay: entry " << i << " is " << codec << " video, which OMT cannot send\n";
+            return 1;
+        }
+    }
+    file.prefetch();
+
+    const OMTMediaFileHeader& header = file.header();
+    int rateN = header.frameRateN > 0 ? header.frameRateN : 60000;
+    int rateD = header.frameRateD > 0 ? header.frameRateD : 1000;
+    if (rate > 0)
+    {
+        rateN = (int)(rate * 1000 + 0.5);
+        rateD = 1000;
+    }
+    std::cout << "replay: " << file.frameCount() << " frames of " << header.width << "x" << header.height << " on "
+              << senderCount << " senders at " << (double)rateN / rateD << " fps" << (unclocked ? " (unclocked)" : "") << "\n";
+    if (header.sampleRate > 0)
+    {
+        std::cout << "replay.audio: " << header.sampleRate << " Hz, " << header.channels << " channels\n";
+    }
+
+    // The index finds the starting point without reading the frames before it
+    uint32_t startFrame = 0;
+    if (startSeconds > 0)
+    {
+        startFrame = file.find(file.entry(0).timestamp + (int64_t)(startSeconds * 10000000));
+        if (startFrame >= file.frameCount())
+        {
+            std::cout << "replay: --start is past the end of the file\n";
+            return 1;
+        }
+        std::cout << "replay.start: entry " << startFrame << " at " << (file.entry(startFrame).timestamp - file.entry(0).timestamp) / 10000000.0 << "s\n";
+    }
+
+    std::vector<ReplaySender> senders(senderCount);
+    for (int i = 0; i < senderCount; i++)
+    {
+        std::string name = "Replay " + std::to_string(i + 1);
+        senders[i].snd = omt_send_create(name.c_str(), OMTQuality_Default);
+        if (!senders[i].snd)
+        {
+            std::cout << "omt_send_create.failed: " << name << "\n";
+            senderCount = i;
+            senders.resize(senderCount);
+            break;
+        }
+    }
+
+    // Start each sender at a different point in the clip, as independent sources would be
+    for (int i = 0; i < senderCount; i++)
+    {
+        uint32_t firstFrame = (uint32_t)((startFrame + (uint64_t)file.frameCount() * i / senderCount) % file.frameCount());
+        senders[i].thread = std::thread(replayLoop, &file, senders[i].snd, firstFrame, rateN, rateD, unclocked);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 1; running && (seconds <= 0 || t <= seconds); t++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::seconds(t));
+        int64_t frames = 0, bytes = 0, dropped = 0;
+        int connections = 0;
+        for (int i = 0; i < senderCount; i++)
+        {
+            OMTStatistics stats = {};
+            omt_send_getvideostatistics(senders[i].snd, &stats);
+            frames += stats.Frames - senders[i].last.Frames;
+            bytes += stats.BytesSent - senders[i].last.BytesSent;
+            dropped += stats.FramesDropped - senders[i].last.FramesDropped;
+            senders[i].last = stats;
+            connections += omt_send_connections(senders[i].snd);
+        }
+        std::cout << "replay: t=" << t << "s " << frames << " fps total, " << bytes * 8 / 1000000.0 << " Mbps, "
+                  << dropped << " dropped, " << connections << " connections\n";
+    }
+
+    running = false;
+    for (int i = 0; i < senderCount; i++)
+    {
+        senders[i].thread.join();
+        omt_send_destroy(senders[i].snd);
+    }
+    return 0;
+}
+
+int main(int argc, const char * argv[])
+{
+    std::cout << "OMTVmxReplay\n";
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+    omt_setloggingfilename("omtvmxreplay.log");
+
+    if (argc >= 4 && !strcasecmp(argv[1], "capture"))
+    {
+        int frames = (argc > 4) ? atoi(argv[4]) : 600;
+        return capture(argv[2], argv[3], frames > 0 ? frames : 600);
+    }
+
+    if (argc >= 4 && !strcasecmp(argv[1], "record"))
+    {
+        std::vector<std::string> sources;
+        int seconds = 0;
+        bool direct = false;
+        for (int a = 3; a < argc; a++)
+        {
+            if (!strcasecmp(argv[a], "--duration") && a + 1 < argc)
+            {
+                seconds = atoi(argv[++a]);
+            }
+            else if (!strcasecmp(argv[a], "--direct"))
+            {
+                direct = true;
+            }
+            else
+            {
+                sources.push_back(argv[a]);
+            }
+        }
+        return record(argv[2], sources, seconds, direct);
+    }
+
+    if (argc >= 3 && !strcasecmp(argv[1], "replay"))
+    {
+        int senderCount = 1;
+        double rate = 0;
+        bool unclocked = false;
+        int seconds = 0;
+        double startSeconds = 0;
+        for (int a = 3; a < argc; a++)
+        {
+            if (!strcasecmp(argv[a], "--senders") && a + 1 < argc)
+            {
+                senderCount = atoi(argv[++a]);
+            }
+            else if (!strcasecmp(argv[a], "--rate") && a + 1 < argc)
+            {
+                rate = atof(argv[++a]);
+            }
+            else if (!strcasecmp(argv[a], "--unclocked"))
+            {
+                unclocked = true;
+            }
+            else if (!strcasecmp(argv[a], "--duration") && a + 1 < argc)
+            {
+                seconds = atoi(argv[++a]);
+            }
+            else if (!strcasecmp(argv[a], "--start") && a + 1 < argc)
+            {
+                startSeconds = atof(argv[++a]);
+            }
+        }
+        return replay(argv[2], senderCount > 0 ? senderCount : 1, rate, unclocked, seconds, startSeconds);
+    }
+
+    printf("Usage : omtvmxreplay capture \"HOST (OMTSOURCE)\" <file> [frames]\n");
+    printf("        omtvmxreplay record <directory> \"HOST (OMTSOURCE)\" [\"HOST (OMTSOURCE)\" ...] [--duration seconds] [--direct]\n");
+    printf("        omtvmxreplay replay <file> [--senders n] [--rate fps] [--unclocked] [--duration seconds] [--start seconds]\n");
+    return 0;
+}